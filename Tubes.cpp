@@ -7,6 +7,10 @@
 #define NUM_LEDS 64
 
 #define USERADIO
+// #define PROFILING                    // per-stage loop timing, printed by 't'
+
+// Define to replay the exact same show on every boot
+// #define RANDOM_SEED 1
 
 #include "beats.h"
 #include "virtual_strip.h"
@@ -15,6 +19,7 @@
 #include "master.h"
 #include "radio.h"
 #include "debug.h"
+#include "scheduler.h"
 
 
 BeatController beats;
@@ -31,10 +36,82 @@ void randomize(long seed) {
   random16_add_entropy( random() );  
 }
 
+// Tasks, most urgent first
+
+void renderFrame() {
+  PROFILE_START(beats);
+  beats.update(); // ~30us
+  PROFILE_END(beats, ProfileBeats);
+
+  controller.update(); // patterns: 0-3000us
+
+  PROFILE_START(debug);
+  debug.update(); // ~25us
+  PROFILE_END(debug, ProfileDebug);
+  if (master)
+    master->updateStatus(&controller, controller.led_strip);
+
+  // Draw after everything else is done
+  controller.led_strip->update(master != NULL); // ~25us
+}
+
+void updateRadio() {
+  controller.updateRadio(scheduler.slack); // sends and handles packets for up to RADIO_RECEIVE_BUDGET_MICROS
+}
+
+void readInputs() {
+  master->update();
+}
+
+#ifdef USELCD
+void updateLcd() {
+  controller.updateLcd(); // <500us per chunk
+}
+#endif
+
+void readKeys() {
+  controller.read_keys();
+}
+
+void everySecond() {
+  randomize(random());
+  controller.led_strip->check_fps();
+}
+
+void printStats() {
+  debug.printStats();
+}
+
+void flushLog() {
+#if LOG_LEVEL > LOG_LEVEL_NONE
+  logger.flush();
+#endif
+}
+
+void setupTasks() {
+  // name, task, period, priority, budget, deadline (all times in us)
+  scheduler.add(F("frame"), renderFrame, LEDs::REFRESH_PERIOD, 0, 3000, 1000);
+  scheduler.add(F("radio"), updateRadio, 1000, 1, RADIO_TASK_BUDGET_MICROS);
+  if (master)
+    scheduler.add(F("inputs"), readInputs, 10000, 2, 300);
+#ifdef USELCD
+  scheduler.add(F("lcd"), updateLcd, 10000, 3, 500);
+#endif
+  scheduler.add(F("keys"), readKeys, 5000, 3, KEY_BUDGET_MICROS);
+  scheduler.add(F("second"), everySecond, 1000000, 4, 100);
+  scheduler.add(F("stats"), printStats, 10000000, 4, 500);
+  scheduler.add(F("log"), flushLog, 5000, 5, 200);
+}
+
 void setup() {
   delay(2000);
   Serial.begin(115200);
+#ifdef RANDOM_SEED
+  randomSeed(RANDOM_SEED);
+  randomize(RANDOM_SEED);
+#else
   randomize(analogRead(0));
+#endif
 
   pinMode(MASTER_PIN, INPUT_PULLUP);
   if (digitalRead(MASTER_PIN) == LOW) {
@@ -47,21 +124,11 @@ void setup() {
   beats.setup();
   controller.setup(master != NULL);
   debug.setup();
+  setupTasks();
 }
 
 
 void loop()
 {
-  EVERY_N_MILLISECONDS( 1000 ) {
-    randomize(random());
-  }
-
-  beats.update(); // ~30us
-  controller.update(); // radio: 0-3000us   patterns: 0-3000us   lcd: ~50000us
-  debug.update(); // ~25us
-  if (master)
-    master->update();
-
-  // Draw after everything else is done
-  controller.led_strip->update(master != NULL); // ~25us
+  scheduler.run();
 }
@@ -0,0 +1,118 @@
+#pragma once
+
+// 16-bit-per-channel frame buffer that the virtual strips and particles are
+// composited into, before one quantize() pass writes the 8-bit LEDs.  Each
+// strip's brightness and fader are applied in a single multiply at full
+// precision, so crossfades and low brightness don't band.
+//
+// Costs 6 bytes per LED, so it's off on the Teensy LC unless HDR_BUFFER is
+// defined.  NO_HDR_DITHER turns off the temporal dithering in quantize().
+
+#if !defined(FASTLED_TEENSYLC) && !defined(NO_HDR_BUFFER)
+#define HDR_BUFFER
+#endif
+
+#ifdef HDR_BUFFER
+
+typedef enum BlendMode: uint8_t {
+  OverwriteBlend=0,
+  MaxBlend=1,    // brighter of each channel, as CRGB's |=
+  AddBlend=2,    // saturating sum: two strips crossfading add up to one
+} BlendMode;
+
+class RGB16 {
+  public:
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+};
+
+inline uint16_t expand8(uint8_t c) {
+  return c * 257;
+}
+
+inline uint16_t add16(uint16_t a, uint16_t b) {
+  uint32_t sum = a + b;
+  return sum > 65535 ? 65535 : sum;
+}
+
+inline void accum_max(RGB16 &p, uint16_t r, uint16_t g, uint16_t b) {
+  if (r > p.r) p.r = r;
+  if (g > p.g) p.g = g;
+  if (b > p.b) p.b = b;
+}
+
+inline void accum_add(RGB16 &p, uint16_t r, uint16_t g, uint16_t b) {
+  p.r = add16(p.r, r);
+  p.g = add16(p.g, g);
+  p.b = add16(p.b, b);
+}
+
+inline void accum_sub(RGB16 &p, uint16_t r, uint16_t g, uint16_t b) {
+  p.r = p.r > r ? p.r - r : 0;
+  p.g = p.g > g ? p.g - g : 0;
+  p.b = p.b > b ? p.b - b : 0;
+}
+
+// Thresholds in bit-reversed order, so consecutive frames alternate high/low
+const static uint8_t hdr_dither[16] = {
+  8, 136, 72, 200, 40, 168, 104, 232, 24, 152, 88, 216, 56, 184, 120, 248,
+};
+
+class AccumBuffer {
+  public:
+    RGB16 pixels[MAX_LEDS];
+    uint8_t frame = 0;
+
+  void clear(uint8_t num_leds) {
+    memset(this->pixels, 0, num_leds * sizeof(RGB16));
+  }
+
+  template<BlendMode MODE>
+  void blend(uint8_t i, uint16_t r, uint16_t g, uint16_t b) {
+    RGB16 &p = this->pixels[i];
+    switch (MODE) {
+      case OverwriteBlend:
+        p.r = r;
+        p.g = g;
+        p.b = b;
+        break;
+
+      case MaxBlend:
+        accum_max(p, r, g, b);
+        break;
+
+      case AddBlend:
+        accum_add(p, r, g, b);
+        break;
+    }
+  }
+
+  // Round every channel down to 8 bits.  With dithering, a threshold that
+  // cycles through 16 levels over 16 frames (offset per pixel) is added
+  // first, so the low byte shows up as the average over those frames.
+  void quantize(CRGB strip[], uint8_t num_leds) {
+    this->frame++;
+
+    const RGB16 *p = this->pixels, *end = this->pixels + num_leds;
+#ifdef NO_HDR_DITHER
+    for (; p < end; p++, strip++) {
+      strip->r = p->r >> 8;
+      strip->g = p->g >> 8;
+      strip->b = p->b >> 8;
+    }
+#else
+    uint8_t phase = this->frame;
+    for (; p < end; p++, strip++, phase++) {
+      uint32_t d = hdr_dither[phase & 0xF];
+      uint32_t r = (p->r + d) >> 8, g = (p->g + d) >> 8, b = (p->b + d) >> 8;
+      // Only 256 can come out, and r - (r >> 8) takes it to 255 without a branch
+      strip->r = r - (r >> 8);
+      strip->g = g - (g >> 8);
+      strip->b = b - (b >> 8);
+    }
+#endif
+  }
+};
+
+#endif
@@ -6,13 +6,24 @@
 
 typedef uint32_t BeatFrame_24_8;  // 24:8 bitwise float
 
-// Regulates the beat counter, running patterns at 256 "fracs" per beat
+// Converts micros * bpm (8.8) into 1/2^24ths of a frac after a 32-bit shift:
+// 2^56 / 60,000,000, rounded.  There are bpm (8.8) fracs per minute.
+#define FRAC_MULTIPLIER 1200959901UL
+
+// Folds elapsed time into the anchor every ~35 minutes, to keep products small
+#define BEAT_REBASE_MICROS (1UL << 31)
+
+// Regulates the beat counter, running patterns at 256 "fracs" per beat.
+// The beat phase is kept as 32.24 fixed point: an anchor phase, plus the
+// time elapsed since it at the current tempo.  Advancing it is one multiply
+// no matter how long the last update took, and nothing is rounded away
+// between updates, so the beat doesn't drift over a long set.
 class BeatController {
   public:
     accum88 bpm = 0;
     BeatFrame_24_8 frac;
-    uint32_t accum = 0;
-    uint32_t micros_per_frac;
+    uint64_t anchor = 0;          // phase at the last sync, in 1/2^24 fracs
+    uint64_t elapsed_micros = 0;  // since the anchor
 
   void setup()
   {
@@ -26,21 +37,44 @@ class BeatController {
   {
     globalTimer.update();
 
-    // Maintains an accumulator with 14 bits of precision
-    this->accum += globalTimer.delta_micros << 8;
-    while (this->accum > this->micros_per_frac) {
-      this->frac++;
-      this->accum -= this->micros_per_frac;
+    this->elapsed_micros += globalTimer.delta_micros;
+    uint64_t phase = this->phase();
+    if (this->elapsed_micros >= BEAT_REBASE_MICROS) {
+      this->anchor = phase;
+      this->elapsed_micros = 0;
     }
+    this->frac = phase >> 24;
+  }
+
+  uint64_t phase() {
+    return this->anchor + this->sub_fracs(this->elapsed_micros);
+  }
+
+  uint64_t sub_fracs(uint64_t micros) {
+    // (micros * bpm * FRAC_MULTIPLIER) >> 32, without a 96-bit product
+    uint64_t p = micros * this->bpm;
+    uint64_t hi = (p >> 32) * FRAC_MULTIPLIER;
+    uint64_t lo = ((p & 0xFFFFFFFF) * FRAC_MULTIPLIER) >> 32;
+    return hi + lo;
+  }
+
+  void slew(int32_t sub_fracs) {
+    // Nudge the phase without touching the tempo
+    this->anchor += sub_fracs;
+    this->frac = this->phase() >> 24;
   }
 
   void sync(accum88 bpm, BeatFrame_24_8 frac) {
     accum88 last_bpm = this->bpm;
+
+    // Keep the part of a frac we've already counted, so resyncing to the
+    // beat we're already on doesn't lose time
+    uint32_t sub_frac = this->phase() & 0xFFFFFF;
+
     this->bpm = bpm;
     this->frac = frac;
-    this->accum = 0;
-
-    this->micros_per_frac = (uint32_t)(15360000000.0 / (float)bpm);
+    this->anchor = ((uint64_t)frac << 24) | sub_frac;
+    this->elapsed_micros = 0;
 
     if (last_bpm != this->bpm)
       this->print_bpm();
@@ -56,7 +90,8 @@ class BeatController {
 
   void start_phrase() {
     this->frac &= -0xFFF;
-    this->accum = 0;
+    this->anchor = (uint64_t)this->frac << 24;
+    this->elapsed_micros = 0;
   }
 
   void print_bpm() {
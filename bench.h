@@ -0,0 +1,268 @@
+#pragma once
+
+#include "pattern.h"
+#include "palette.h"
+#include "virtual_strip.h"
+#include "radio.h"
+
+// On-device benchmark of every background pattern under every sync mode,
+// for a sample of palettes, at the physical and the virtual width (or the
+// DOUBLED width, when the strips aren't oversampled).
+// Results are printed as CSV so they can be captured and compared between
+// firmware releases.  The packet checksums are measured the same way, and
+// the noise kernel against the inoise8 calls it replaced, checking that both
+// give the same values.  Blending two crossfading strips is measured into
+// the 8-bit LEDs and, with HDR_BUFFER, into the accumulator plus quantize().
+
+#define BENCH_FRAMES 32
+#define BENCH_PALETTES 3
+#define BENCH_SYNC_MODES 5
+#define BENCH_PACKETS 256
+
+// Teensy 3.x/4.x have a cycle counter; the LC only has micros()
+#ifdef ARM_DWT_CYCCNT
+#define BENCH_CYCLES
+#endif
+
+void bench_start_cycles() {
+#ifdef BENCH_CYCLES
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+}
+
+uint32_t bench_cycles() {
+#ifdef BENCH_CYCLES
+  return ARM_DWT_CYCCNT;
+#else
+  return 0;
+#endif
+}
+
+void benchmark_pattern(VirtualStrip *strip, uint8_t pattern_id, uint8_t sync, uint8_t palette_id, uint16_t width) {
+  Background background;
+  background.animate = gPatterns[pattern_id].backgroundFn;
+  background.palette = gPalettes[palette_id];
+  background.sync = (SyncMode)sync;
+
+  strip->num_leds = width;
+  strip->load(background);
+
+  BeatFrame_24_8 frame = 0;
+  uint32_t start_cycles = bench_cycles();
+  uint32_t start = micros();
+  for (uint8_t f = 0; f < BENCH_FRAMES; f++) {
+    oscillators.update(frame);
+    strip->update(frame, 0);
+    frame += 2;  // ~300fps at 120bpm
+  }
+  uint32_t elapsed = micros() - start;
+  uint32_t cycles = bench_cycles() - start_cycles;
+
+  Serial.print(pattern_id);
+  Serial.print(F(","));
+  Serial.print(sync);
+  Serial.print(F(","));
+  Serial.print(palette_id);
+  Serial.print(F(","));
+  Serial.print(width);
+  Serial.print(F(","));
+  Serial.print(elapsed * 1000 / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.println(cycles / BENCH_FRAMES);
+}
+
+void benchmark_patterns(uint8_t num_leds) {
+  uint16_t virtual_width = VIRTUAL_RATIO > 1 ? VIRTUAL_WIDTH(num_leds) : num_leds * 2 + 1;
+  VirtualStrip *strip = new VirtualStrip(num_leds);
+  if (!strip) {
+    Serial.println(F("No memory for benchmark"));
+    return;
+  }
+  bench_start_cycles();
+
+  Serial.println(F("pattern,sync,palette,leds,ns_per_frame,cycles_per_frame"));
+  for (uint8_t p = 0; p < gPatternCount; p++) {
+    // Entries that share a background function are only measured once
+    bool seen = false;
+    for (uint8_t q = 0; q < p; q++) {
+      if (gPatterns[q].backgroundFn == gPatterns[p].backgroundFn)
+        seen = true;
+    }
+    if (seen)
+      continue;
+
+    for (uint8_t sync = 0; sync < BENCH_SYNC_MODES; sync++) {
+      for (uint8_t c = 0; c < BENCH_PALETTES; c++) {
+        uint8_t palette_id = c * gGradientPaletteCount / BENCH_PALETTES;
+        benchmark_pattern(strip, p, sync, palette_id, num_leds);
+        benchmark_pattern(strip, p, sync, palette_id, virtual_width);
+      }
+    }
+  }
+  Serial.println(F("done"));
+
+  delete strip;
+}
+
+void benchmark_checksum(const __FlashStringHelper *name, uint16_t (*checksum)(const uint8_t *, uint8_t)) {
+  RadioMessage message;
+  for (uint8_t i = 0; i < sizeof(message.data); i++)
+    message.data[i] = random8();
+
+  uint16_t total = 0;
+  uint32_t start_cycles = bench_cycles();
+  uint32_t start = micros();
+  for (uint16_t p = 0; p < BENCH_PACKETS; p++) {
+    message.data[0] = p;
+    total += checksum(message.data, sizeof(message.data));
+  }
+  uint32_t elapsed = micros() - start;
+  uint32_t cycles = bench_cycles() - start_cycles;
+
+  Serial.print(name);
+  Serial.print(F(","));
+  Serial.print(elapsed * 1000 / BENCH_PACKETS);
+  Serial.print(F(","));
+  Serial.print(cycles / BENCH_PACKETS);
+  Serial.print(F(","));
+  Serial.println(total, HEX);  // keeps the loop from being optimized out
+}
+
+void benchmark_checksums() {
+  bench_start_cycles();
+  Serial.println(F("checksum,ns_per_packet,cycles_per_packet,sum"));
+  benchmark_checksum(F("crc16"), crc16);
+  benchmark_checksum(F("legacy"), legacy_crc);
+  Serial.println(F("done"));
+}
+
+void benchmark_noise(uint16_t width) {
+  uint16_t total = 0;
+  uint32_t mismatches = 0;
+
+  uint32_t start_cycles = bench_cycles();
+  uint32_t start = micros();
+  for (uint8_t f = 0; f < BENCH_FRAMES; f++) {
+    for (uint16_t i = 0; i < width; i++)
+      total += inoise8(i * 17, f * 37);
+  }
+  uint32_t inoise_elapsed = micros() - start;
+  uint32_t inoise_cycles = bench_cycles() - start_cycles;
+
+  start_cycles = bench_cycles();
+  start = micros();
+  for (uint8_t f = 0; f < BENCH_FRAMES; f++) {
+    NoiseRow row(0, 17, f * 37);
+    for (uint16_t i = 0; i < width; i++)
+      total += row.next();
+  }
+  uint32_t row_elapsed = micros() - start;
+  uint32_t row_cycles = bench_cycles() - start_cycles;
+
+  // Every row of one lattice cell's height, at full width
+  for (uint16_t y = 0; y < 256; y++) {
+    NoiseRow row(0, 17, y);
+    for (uint16_t i = 0; i < width; i++) {
+      if (row.next() != inoise8(i * 17, y))
+        mismatches++;
+    }
+  }
+
+  Serial.println(F("noise,leds,ns_per_frame,cycles_per_frame,sum"));
+  Serial.print(F("inoise8,"));
+  Serial.print(width);
+  Serial.print(F(","));
+  Serial.print(inoise_elapsed * 1000 / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.print(inoise_cycles / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.println(total, HEX);
+  Serial.print(F("row,"));
+  Serial.print(width);
+  Serial.print(F(","));
+  Serial.print(row_elapsed * 1000 / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.print(row_cycles / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.println(total, HEX);
+  Serial.print(F("mismatches,"));
+  Serial.println(mismatches);
+  Serial.println(F("done"));
+}
+
+void bench_print_blend(const __FlashStringHelper *name, uint8_t strips, uint8_t num_leds, uint32_t elapsed, uint32_t cycles) {
+  Serial.print(name);
+  Serial.print(F(","));
+  Serial.print(strips);
+  Serial.print(F(","));
+  Serial.print(num_leds);
+  Serial.print(F(","));
+  Serial.print(elapsed * 1000 / BENCH_FRAMES);
+  Serial.print(F(","));
+  Serial.println(cycles / BENCH_FRAMES);
+}
+
+void benchmark_blend(uint8_t num_leds) {
+  VirtualStrip *strip = new VirtualStrip(VIRTUAL_WIDTH(num_leds));
+  CRGB *leds = new CRGB[num_leds];
+#ifdef HDR_BUFFER
+  AccumBuffer *accum = new AccumBuffer();
+  bool allocated = strip && leds && accum;
+#else
+  bool allocated = strip && leds;
+#endif
+  if (!allocated) {
+    // Free whichever did fit: on the LC a leak lasts until reboot
+    Serial.println(F("No memory for benchmark"));
+#ifdef HDR_BUFFER
+    delete accum;
+#endif
+    delete[] leds;
+    delete strip;
+    return;
+  }
+  bench_start_cycles();
+
+  Background background;
+  background.animate = gPatterns[0].backgroundFn;
+  background.palette = gPalettes[0];
+  background.sync = All;
+  strip->load(background);
+  strip->fader = 32768;  // mid crossfade
+  oscillators.update(0);
+  strip->update(0, 0);
+
+  // A steady strip, then the same strip standing in for both sides of a
+  // crossfade
+  Serial.println(F("blend,strips,leds,ns_per_frame,cycles_per_frame"));
+  for (uint8_t strips = 1; strips <= 2; strips++) {
+    uint32_t start_cycles = bench_cycles();
+    uint32_t start = micros();
+    for (uint8_t f = 0; f < BENCH_FRAMES; f++) {
+      strip->blend(leds, num_leds, 255, true);
+      if (strips > 1)
+        strip->blend(leds, num_leds, 255, false);
+    }
+    bench_print_blend(F("8bit"), strips, num_leds, micros() - start, bench_cycles() - start_cycles);
+
+#ifdef HDR_BUFFER
+    start_cycles = bench_cycles();
+    start = micros();
+    for (uint8_t f = 0; f < BENCH_FRAMES; f++) {
+      strip->blend(accum, num_leds, 255, OverwriteBlend);
+      if (strips > 1)
+        strip->blend(accum, num_leds, 255, MaxBlend);
+      accum->quantize(leds, num_leds);
+    }
+    bench_print_blend(F("hdr"), strips, num_leds, micros() - start, bench_cycles() - start_cycles);
+#endif
+  }
+#ifdef HDR_BUFFER
+  delete accum;
+#endif
+  Serial.println(F("done"));
+
+  delete[] leds;
+  delete strip;
+}
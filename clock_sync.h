@@ -0,0 +1,101 @@
+#pragma once
+
+#include "beats.h"
+
+#define SYNC_SNAP_FRACS 64           // bigger errors are corrected by jumping
+#define SYNC_SLEW_SHIFT 3            // slew at most 1/8th of the beat rate
+#define SYNC_TRIM_SHIFT 14           // integral gain of the tempo trim; low, to ride out the quantized fracs
+#define SYNC_MAX_TRIM (1L << 14)     // +/-1000ppm, in 1/2^24ths
+#define SYNC_LATENCY_MICROS 600      // send + airtime of one packet at 1Mbps
+
+// Disciplines the local beat clock to the master's, like a PLL.  Each update
+// from the master measures the phase error (allowing for the time the packet
+// spent in flight).  Small errors are slewed out gradually, so animations
+// never visibly jump, and a tempo trim integrates the error that remains
+// from one update to the next.  Only large errors jump the clock.
+class ClockDiscipline {
+  public:
+    BeatController *beats;
+    uint64_t last_phase = 0;
+    accum88 last_bpm = 0;
+    int32_t pending = 0;   // phase correction still to slew, in 1/2^24 fracs
+    int32_t trim = 0;      // tempo correction, in 1/2^24ths of the beat rate
+    int16_t error = 0;     // fracs behind (+) or ahead (-) of the master at the last update
+
+  ClockDiscipline(BeatController *beats) {
+    this->beats = beats;
+  }
+
+  void reset() {
+    this->last_phase = this->beats->phase();
+    this->last_bpm = this->beats->bpm;
+    this->pending = 0;
+    this->trim = 0;
+  }
+
+  void update() {
+    // Someone else changed the tempo: start over
+    if (this->beats->bpm != this->last_bpm) {
+      this->reset();
+      return;
+    }
+
+    uint64_t phase = this->beats->phase();
+    int64_t advance = phase - this->last_phase;
+    this->last_phase = phase;
+
+    // The clock was jumped, or the loop stalled: skip this step
+    if (advance <= 0 || advance > ((int64_t)SYNC_SNAP_FRACS << 24))
+      return;
+
+    // Slewing at most a fraction of the advance keeps the beat moving forward
+    int32_t limit = advance >> SYNC_SLEW_SHIFT;
+    int32_t correction = this->pending;
+    if (correction > limit)
+      correction = limit;
+    if (correction < -limit)
+      correction = -limit;
+    this->pending -= correction;
+
+    correction += (advance * this->trim) >> 24;
+    if (correction) {
+      this->beats->slew(correction);
+      this->last_phase += correction;
+    }
+  }
+
+  // latency_micros is how long ago the master sent frac, relative to the
+  // last beats->update(); it's negative if the packet arrived after that
+  void sync(accum88 bpm, BeatFrame_24_8 frac, int32_t latency_micros=SYNC_LATENCY_MICROS) {
+    if (bpm != this->beats->bpm) {
+      this->beats->sync(bpm, frac);
+      this->reset();
+      return;
+    }
+
+    // The master is somewhere in the frac it sent, plus the time since then
+    uint64_t target = ((uint64_t)frac << 24) + (1 << 23);
+    if (latency_micros >= 0)
+      target += this->beats->sub_fracs(latency_micros);
+    else
+      target -= this->beats->sub_fracs(-latency_micros);
+    int64_t error = (int64_t)(target - (this->beats->phase() + this->pending));
+    int64_t snap = (int64_t)SYNC_SNAP_FRACS << 24;
+
+    if (error > snap || error < -snap) {
+      this->error = error > 0 ? 32767 : -32767;
+      this->beats->sync(bpm, target >> 24);
+      this->reset();
+      return;
+    }
+
+    this->error = (error + (1 << 23)) >> 24;
+    this->pending += error;
+
+    this->trim += error >> SYNC_TRIM_SHIFT;
+    if (this->trim > SYNC_MAX_TRIM)
+      this->trim = SYNC_MAX_TRIM;
+    if (this->trim < -SYNC_MAX_TRIM)
+      this->trim = -SYNC_MAX_TRIM;
+  }
+};
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "beats.h"
+#include "clock_sync.h"
 
 #include "pattern.h"
 #include "palette.h"
+#include "palette_cache.h"
 #include "effects.h"
 #include "global_state.h"
+#include "bench.h"
+#include "scheduler.h"
 
 
 #include "led_strip.h"
@@ -16,8 +20,11 @@
 
 const static uint8_t DEFAULT_MASTER_BRIGHTNESS = 144;
 
-const static CommandId COMMAND_UPDATE = 0x411;
-const static CommandId COMMAND_NEXT = 0x321;
+const static CommandId COMMAND_STATE = 0x412;    // packed current + next TubeState
+#ifdef RADIO_V1_COMPAT
+const static CommandId COMMAND_UPDATE = 0x411;   // version 1: raw current TubeState
+const static CommandId COMMAND_NEXT = 0x321;     // version 1: raw next TubeState
+#endif
 const static CommandId COMMAND_RESET = 0x911;
 const static CommandId COMMAND_FIREWORK = 0xFFF;
 const static CommandId COMMAND_HELLO = 0x000;
@@ -30,6 +37,27 @@ typedef struct {
   uint8_t brightness;
 } ControllerOptions;
 
+#define KEY_LINE_MAX 32
+#define KEY_BUDGET_MICROS 500    // time allowed for reading & running key commands per call
+
+// Serial commands are a key, then an argument parsed according to its type
+typedef enum KeyArg: uint8_t {
+  NoArg=0,
+  NumberArg=1,     // ###.#, as accum88
+  RepeatArg=2,     // how many times the key is repeated, e.g. "---"
+} KeyArg;
+
+class PatternController;
+typedef void (PatternController::*KeyHandler)(accum88 arg);
+
+typedef struct {
+  char key;
+  KeyArg arg;
+  accum88 min;     // smaller numbers are refused
+  KeyHandler handler;
+  const char *help;
+} KeyCommand;
+
 #define NEXT_PATTERN_TIME 53000
 #define NEXT_PALETTE_TIME 27000
 
@@ -69,15 +97,11 @@ class Button {
 
 class PatternController : public MessageReceiver {
   public:
-    const static int FRAMES_PER_SECOND = 300;  // how often we animate, in frames per second
-    const static int REFRESH_PERIOD = 1000 / FRAMES_PER_SECOND;  // how often we animate, in milliseconds
-
     uint8_t num_leds;
     VirtualStrip *vstrips[NUM_VSTRIPS];
     uint8_t next_vstrip = 0;
     bool isMaster = false;
     
-    Timer graphicsTimer;
     Timer updateTimer;
     Timer slaveTimer;
 
@@ -85,12 +109,21 @@ class PatternController : public MessageReceiver {
     Lcd *lcd;
 #endif
     LEDs *led_strip;
+#ifdef HDR_BUFFER
+    AccumBuffer *accum;
+#endif
     BeatController *beats;
+    ClockDiscipline *sync_clock;
+    bool following = false;        // had a master at the last updateRadio()
     Radio *radio;
     Effects *effects;
 
     ControllerOptions options;
-    char key_buffer[20] = {0};
+    char key_buffer[KEY_LINE_MAX] = {0};
+    uint8_t key_length = 0;
+    bool key_overflow = false;
+
+    static const KeyCommand key_commands[];
 
     Energy energy=LowEnergy;
     TubeState current_state;
@@ -102,16 +135,16 @@ class PatternController : public MessageReceiver {
     this->lcd = new Lcd();
 #endif
     this->led_strip = new LEDs(num_leds);
+#ifdef HDR_BUFFER
+    this->accum = new AccumBuffer();
+#endif
     this->beats = beats;
+    this->sync_clock = new ClockDiscipline(beats);
     this->radio = radio;
     this->effects = new Effects();
 
     for (uint8_t i=0; i < NUM_VSTRIPS; i++) {
-#ifdef DOUBLED
-      this->vstrips[i] = new VirtualStrip(num_leds * 2 + 1);
-#else
-      this->vstrips[i] = new VirtualStrip(num_leds);
-#endif
+      this->vstrips[i] = new VirtualStrip(VIRTUAL_WIDTH(num_leds));
     }
 
   }
@@ -145,13 +178,7 @@ class PatternController : public MessageReceiver {
 
   void update()
   {
-    this->read_keys();
-
-    // If master has expired, clear masterId
-    if (this->radio->masterTubeId && this->slaveTimer.ended()) {
-      Serial.println(F("I have no master"));
-      this->radio->masterTubeId = 0;
-    }
+    this->sync_clock->update();
 
     // Update patterns to the beat
     this->update_beat();
@@ -170,29 +197,54 @@ class PatternController : public MessageReceiver {
       this->next_state.effect_phrase = phrase + this->set_next_effect(phrase);
     }
 
-    // If alone or master, send out updates
-    if (!this->radio->masterTubeId and this->updateTimer.ended()) {
-      this->send_update();
+    this->updateGraphics();
+  }
+
+  // `slack` is how long until the next frame is due; the radio stops
+  // handling packets in time for it
+  void updateRadio(uint32_t slack=RADIO_TASK_BUDGET_MICROS) {
+    uint32_t start = micros();
+
+    // If master has expired, clear masterId
+    if (this->radio->masterTubeId && this->slaveTimer.ended()) {
+      Serial.println(F("I have no master"));
+      this->radio->masterTubeId = 0;
+      this->radio->master_millis = millis();
     }
 
-    this->radio->receiveCommands(this);
+    // Leading now: drop the slew and trim that chased the old master
+    if (this->following && !this->radio->masterTubeId)
+      this->sync_clock->reset();
+    this->following = this->radio->masterTubeId != 0;
 
-    if (this->graphicsTimer.every(REFRESH_PERIOD)) {
-      this->updateGraphics();
+    // If alone or master, send out updates
+    this->radio->beat_frame = this->current_state.beat_frame;
+    if (!this->radio->masterTubeId and this->updateTimer.ended() and this->radio->inSlot()) {
+      this->send_update();
     }
 
+    PROFILE_START(radio);
+    // Leave room for the send or packet that overruns the budget
+    uint32_t budget = max(slack, (uint32_t)RADIO_TASK_BUDGET_MICROS) - RADIO_SEND_MICROS;
+    budget = min(budget, (uint32_t)RADIO_RECEIVE_BUDGET_MICROS);
+    this->radio->receiveCommands(this, start, budget);
+    PROFILE_END(radio, ProfileRadio);
+  }
+
 #ifdef USELCD
-    if (this->lcd->active) {
-      this->lcd->size(1);
-      this->lcd->write(0,56, this->current_state.beat_frame);
-      this->lcd->write(80,56, this->x_axis);
-      this->lcd->write(100,56, this->y_axis);
-      this->lcd->show();
-
-      this->lcd->update();
-    }
-#endif
+  void updateLcd() {
+    if (!this->lcd->active)
+      return;
+
+    // Only changed fields are redrawn, and update() sends a small chunk per call
+    this->lcd->size(1);
+    this->lcd->write(0,56, this->current_state.beat_frame);
+    this->lcd->write(80,56, this->radio->tubeId);
+    this->lcd->write(100,56, this->radio->masterTubeId);
+
+    this->lcd->update();
   }
+#endif
 
   void restart_phrase() {
     this->beats->start_phrase();
@@ -224,36 +276,49 @@ class PatternController : public MessageReceiver {
       this->energy = LowEnergy;
   }
   
+  bool send_state() {
+#ifdef RADIO_V1_COMPAT
+    // Version 1 tubes only know the raw states, sent separately
+    static_assert(sizeof(TubeState) <= MESSAGE_DATA_MAX_SIZE, "TubeState doesn't fit a message");
+    bool sent = this->radio->sendCommand(COMMAND_UPDATE, &this->current_state, sizeof(TubeState));
+    this->radio->sendCommand(COMMAND_NEXT, &this->next_state, sizeof(TubeState));
+    return sent;
+#endif
+    uint8_t buffer[STATE_WIRE_SIZE];
+    uint8_t size = pack_states(this->current_state, this->next_state, buffer);
+    return this->radio->sendCommand(COMMAND_STATE, buffer, size);
+  }
+
   void send_update() {
-    this->current_state.print();
-    Serial.print(F(" "));
+    this->log_state(LogUpdateSent, 0, this->current_state);
+    this->log_next();
 
-    if (this->radio->sendCommand(COMMAND_UPDATE, &this->current_state, sizeof(this->current_state))) {
+    if (this->send_state()) {
       this->radio->radioFailures = 0;
       this->updateTimer.snooze(RADIO_SENDPERIOD);
     } else {
       // might have been a collision.  Back off by a small amount determined by ID
-      Serial.println(F("Radio update failed"));
       this->updateTimer.snooze( this->radio->tubeId & 0x7F );
       this->radio->radioFailures++;
+      LOG_ERROR(LogUpdateFailed, this->radio->tubeId, 0, this->radio->radioFailures);
       if (this->radio->radioFailures > 100) {
         this->radio->setup(this->isMaster);
         this->radio->radioRestarts++;
       }
     }
+  }
+
+  void log_state(LogEvent event, uint8_t fromId, TubeState &state) {
+    LOG_INFO(event, fromId, (state.pattern_id << 8) | state.palette_id, state.beat_frame);
+  }
 
+  void log_next() {
     uint16_t phrase = this->current_state.beat_frame >> 12;
-    Serial.print(F("    "));
-    Serial.print(this->next_state.pattern_phrase - phrase);
-    Serial.print(F("P "));
-    Serial.print(this->next_state.palette_phrase - phrase);
-    Serial.print(F("C "));
-    Serial.print(this->next_state.effect_phrase - phrase);
-    Serial.print(F("E: "));
-    this->next_state.print();
-    Serial.print(F(" "));
-    this->radio->sendCommand(COMMAND_NEXT, &this->next_state, sizeof(this->next_state));
-    Serial.println();    
+    LOG_DEBUG(LogNext, this->next_state.effect_params.effect,
+              (this->next_state.pattern_id << 8) | this->next_state.palette_id,
+              ((uint32_t)phrase_offset(this->next_state.pattern_phrase, phrase) << 16)
+              | (phrase_offset(this->next_state.palette_phrase, phrase) << 8)
+              | phrase_offset(this->next_state.effect_phrase, phrase));
   }
 
   void background_changed() {
@@ -354,7 +419,7 @@ class PatternController : public MessageReceiver {
   void update_background() {
     Background background;
     background.animate = gPatterns[this->current_state.pattern_id].backgroundFn;
-    background.palette = gPalettes[this->current_state.palette_id];
+    background.palette = paletteCache.get(this->current_state.palette_id);
     background.sync = (SyncMode)this->current_state.pattern_sync_id;
 
     // re-use virtual strips to prevent heap fragmentation
@@ -411,43 +476,90 @@ class PatternController : public MessageReceiver {
     }
     lastFrame = beat_frame;
 
+    // Shared by every strip's pattern
+    oscillators.update(beat_frame);
+
     VirtualStrip *first_strip = NULL;
     for (uint8_t i=0; i < NUM_VSTRIPS; i++) {
       VirtualStrip *vstrip = this->vstrips[i];
       if (vstrip->fade == Dead)
         continue;
 
-      // Remember the first strip
+      PROFILE_START(animate);
+      vstrip->update(beat_frame, beat_pulse);
+      PROFILE_END(animate, ProfileAnimate);
+
+      // Finished fading out just now, so it draws nothing
+      if (vstrip->fade == Dead)
+        continue;
+
+      // Remember the first strip, which overwrites last frame's pixels
       if (first_strip == NULL)
         first_strip = vstrip;
-     
-      vstrip->update(beat_frame, beat_pulse);
+
+      PROFILE_START(blend);
+#ifdef HDR_BUFFER
+      // Crossfading strips keep the brighter of each channel, like the 8-bit
+      // path, so boards with and without the buffer crossfade alike
+      vstrip->blend(this->accum, this->num_leds, this->options.brightness, vstrip == first_strip ? OverwriteBlend : MaxBlend);
+#else
       vstrip->blend(this->led_strip->leds, this->led_strip->num_leds, this->options.brightness, vstrip == first_strip);
+#endif
+      PROFILE_END(blend, ProfileBlend);
+    }
+    // Nothing drew, so nothing overwrote last frame
+    if (first_strip == NULL) {
+#ifdef HDR_BUFFER
+      this->accum->clear(this->num_leds);
+#else
+      fill_solid(this->led_strip->leds, this->num_leds, CRGB::Black);
+#endif
     }
 
-    this->effects->update(first_strip, beat_frame, (BeatPulse)beat_pulse);
+    // New effects take their colors from the first strip's palette
+    PROFILE_START(effects_animate);
+    if (first_strip)
+      this->effects->update(first_strip, beat_frame, (BeatPulse)beat_pulse);
+    PROFILE_END(effects_animate, ProfileEffectsAnimate);
+
+    PROFILE_START(effects_draw);
+#ifdef HDR_BUFFER
+    this->effects->draw(this->accum->pixels, this->num_leds);
+#else
     this->effects->draw(this->led_strip->leds, this->num_leds);    
+#endif
+    PROFILE_END(effects_draw, ProfileEffectsDraw);
+
+#ifdef HDR_BUFFER
+    PROFILE_START(quantize);
+    this->accum->quantize(this->led_strip->leds, this->num_leds);
+    PROFILE_END(quantize, ProfileQuantize);
+#endif
   }
 
   virtual void acknowledge() {
     addFlash();
   }
 
-  virtual void onCommand(uint8_t fromId, CommandId command, void *data) {
+  void print_from(uint8_t fromId) {
     if (fromId) {
       Serial.print(F("From "));
       Serial.print(fromId);
       Serial.print(F(": "));
     }
-    
+  }
+
+  virtual void onCommand(uint8_t fromId, CommandId command, void *data) {
     switch (command) {
       case COMMAND_FIREWORK:
-        Serial.print(F("fireworks"));
+        this->print_from(fromId);
+        Serial.println(F("fireworks"));
         this->acknowledge();
         return;
   
       case COMMAND_RESET:
-        Serial.print(F("reset"));
+        this->print_from(fromId);
+        Serial.println(F("reset"));
         return;
   
       case COMMAND_BRIGHTNESS: {
@@ -457,73 +569,105 @@ class PatternController : public MessageReceiver {
       }
   
       case COMMAND_HELLO:
-        Serial.print(F("hello"));
+        this->print_from(fromId);
+        Serial.println(F("hello"));
         this->updateTimer.stop();
         return;
   
       case COMMAND_OPTIONS: {
-        Serial.print(F("options"));
+        this->print_from(fromId);
+        Serial.println(F("options"));
         memcpy(&this->options, data, sizeof(this->options));
         return;
       }
 
+#ifdef RADIO_V1_COMPAT
       case COMMAND_NEXT: {
-        Serial.print(F(" next "));
         if (fromId < this->radio->masterTubeId) {
-          Serial.print(F(" (ignoring)"));
+          LOG_DEBUG(LogIgnored, fromId, LogNotMaster, 0);
           return;
-        } 
+        }
 
         memcpy(&this->next_state, data, sizeof(TubeState));
-        this->next_state.print();
-        Serial.print(F(" (obeying)"));
+        this->log_next();
         return;
       }
-  
+
       case COMMAND_UPDATE: {
-        Serial.print(F(" update "));
         if (fromId < this->radio->masterTubeId) {
-          Serial.print(F(" (ignoring)"));
+          LOG_DEBUG(LogIgnored, fromId, LogNotMaster, 0);
           return;
-        } 
+        }
 
         TubeState state;
         memcpy(&state, data, sizeof(TubeState));
-        state.print();
-        Serial.print(F(" (obeying)"));
-  
-        // Track the last time we received a message from our master
-        this->slaveTimer.start(RADIO_SENDPERIOD * 8);
-
-        // Catch up to this state
-        this->load_pattern(state);
-        this->load_palette(state);
-        this->load_effect(state);
-        this->beats->sync(state.bpm, state.beat_frame);
+        this->obey_update(fromId, state);
+        return;
+      }
+#endif
+
+      case COMMAND_STATE: {
+        if (fromId < this->radio->masterTubeId) {
+          LOG_DEBUG(LogIgnored, fromId, LogNotMaster, 0);
+          return;
+        } 
+
+        TubeState state;
+        if (!unpack_states((uint8_t *)data, state, this->next_state)) {
+          LOG_ERROR(LogBadFormat, fromId, *(uint8_t *)data, 0);
+          return;
+        }
+        this->obey_update(fromId, state);
+        this->log_next();
         return;
       }
     }
   
+    this->print_from(fromId);
     Serial.print(F("UNKNOWN "));
-    Serial.print(command, HEX);
+    Serial.println(command, HEX);
+  }
+
+  void obey_update(uint8_t fromId, TubeState &state) {
+    this->log_state(LogObeyed, fromId, state);
+
+    // Track the last time we received a message from our master
+    this->slaveTimer.start(RADIO_SENDPERIOD * 8);
+
+    // Catch up to this state
+    this->load_pattern(state);
+    this->load_palette(state);
+    this->load_effect(state);
+    int32_t latency = SYNC_LATENCY_MICROS + (int32_t)(globalTimer.now_micros - this->radio->received_micros);
+    this->sync_clock->sync(state.bpm, state.beat_frame, latency);
+    LOG_INFO(LogClockError, 0, this->sync_clock->error, this->sync_clock->trim);
   }
 
   void read_keys() {
-    if (!Serial.available())
-      return;
-      
-    char c = Serial.read();
-    char *k = this->key_buffer;
-    uint8_t max = sizeof(this->key_buffer);
-    for (uint8_t i=0; *k && (i < max-1); i++) {
-      k++;
-    }
-    if (c == 10) {
-      this->keyboard_command(this->key_buffer);
-      this->key_buffer[0] = 0;
-    } else {
-      *k++ = c;
-      *k = 0;    
+    // Drain everything that has arrived, so pasted scripts aren't paced by the loop
+    uint32_t start = micros();
+    while (Serial.available() && micros() - start < KEY_BUDGET_MICROS) {
+      char c = Serial.read();
+      if (c == '\r')
+        continue;
+
+      if (c == '\n') {
+        if (this->key_overflow)
+          Serial.println(F("Command too long"));
+        else
+          this->keyboard_command(this->key_buffer);
+        this->key_length = 0;
+        this->key_buffer[0] = 0;
+        this->key_overflow = false;
+        continue;
+      }
+
+      if (this->key_length < sizeof(this->key_buffer) - 1) {
+        this->key_buffer[this->key_length++] = c;
+        this->key_buffer[this->key_length] = 0;
+      } else {
+        this->key_overflow = true;
+      }
     }
   }
 
@@ -554,121 +698,146 @@ class PatternController : public MessageReceiver {
   }
 
   void keyboard_command(char *command) {
-    uint8_t b;
-    accum88 arg = this->parse_number(command+1);
-    
-    switch (command[0]) {
-      case 'f':
-        this->radio->sendCommandFrom(255, COMMAND_FIREWORK, NULL, 0);
-        this->onCommand(0, COMMAND_FIREWORK, NULL);
-        Serial.println();
-        break;
+    if (!command[0])
+      return;
 
-      case 'i':
-        this->radio->resetId(arg >> 8);
-        break;
+    for (const KeyCommand *k = key_commands; k->key; k++) {
+      if (k->key != command[0])
+        continue;
 
-      case 'd':
-        this->setDebugging(!this->options.debugging);
-        break;
-      
-      case '-':
-        b = this->options.brightness;
-        while (*command++ == '-')
-          b -= 5;
-        this->setBrightness(b - 5);
-        break;
-      case '+':
-        b = this->options.brightness;
-        while (*command++ == '+')
-          b += 5;
-        this->setBrightness(b + 5);
-        return;
-      case 'l':
-        if (arg < 5*256) {
-          Serial.println(F("nope"));
-          return;
-        }
-        this->setBrightness(arg >> 8);
-        return;
+      accum88 arg = 0;
+      switch (k->arg) {
+        case NoArg:
+          break;
 
-      case 'b':
-        if (arg < 60*256) {
-          Serial.println(F("nope"));
-          return;
-        }
-        this->beats->set_bpm(arg);
-        this->update_beat();
-        this->send_update();
-        return;
+        case NumberArg:
+          arg = this->parse_number(command+1);
+          if (arg < k->min) {
+            Serial.println(F("nope"));
+            return;
+          }
+          break;
 
-      case 's':
-        this->beats->start_phrase();
-        this->update_beat();
-        this->send_update();
-        return;
+        case RepeatArg:
+          while (command[arg] == k->key)
+            arg++;
+          break;
+      }
 
-      case 'n':
-        this->force_next();
-        return;
+      (this->*(k->handler))(arg);
+      return;
+    }
 
-      case 'p':
-        this->next_state.pattern_phrase = 0;
-        this->next_state.pattern_id = arg >> 8;
-        this->next_state.pattern_sync_id = All;
-        this->update_next();
-        return;        
-        
-      case 'm':
-        this->next_state.pattern_phrase = 0;
-        this->next_state.pattern_id = this->current_state.pattern_id;
-        this->next_state.pattern_sync_id = arg >> 8;
-        this->update_next();
-        return;
-        
-      case 'c':
-        this->next_state.palette_phrase = 0;
-        this->next_state.palette_id = arg >> 8;
-        this->update_next();
-        return;
-        
-      case 'e':
-        this->next_state.effect_phrase = 0;
-        this->next_state.effect_params = gEffects[(arg >> 8) % gEffectCount].params;
-        this->update_next();
-        return;
+    Serial.println(F("? for help"));
+  }
 
-      case '%':
-        this->next_state.effect_phrase = 0;
-        this->next_state.effect_params = this->current_state.effect_params;
-        this->next_state.effect_params.chance = arg;
-        this->update_next();
-        return;
+  void key_fireworks(accum88 arg) {
+    this->radio->sendCommandFrom(255, COMMAND_FIREWORK, NULL, 0);
+    this->onCommand(0, COMMAND_FIREWORK, NULL);
+  }
 
-      case 'h':
-        // Pretend to receive a HELLO
-        this->onCommand(0, COMMAND_HELLO, NULL);
-        Serial.println();
-        return;
+  void key_id(accum88 arg) {
+    this->radio->resetId(arg >> 8);
+  }
 
-      case 'g':
-        for (int i=0; i< 10; i++)
-          addGlitter();
-        break;
+  void key_debugging(accum88 arg) {
+    this->setDebugging(!this->options.debugging);
+  }
 
-      case '?':
-        Serial.println(F("b###.# - set bpm"));
-        Serial.println(F("s - start phrase"));
-        Serial.println();
-        Serial.println(F("p### - patterns"));
-        Serial.println(F("m### - sync mode"));
-        Serial.println(F("c### - colors"));
-        Serial.println(F("e### - effects"));
-        Serial.println();
-        Serial.println(F("i### - set ID"));
-        Serial.println(F("d - toggle debugging"));
-        Serial.println(F("l### - brightness"));
-    }
+  void key_dimmer(accum88 times) {
+    this->setBrightness(this->options.brightness - 5 * (times + 1));
+  }
+
+  void key_brighter(accum88 times) {
+    this->setBrightness(this->options.brightness + 5 * (times + 1));
+  }
+
+  void key_brightness(accum88 arg) {
+    this->setBrightness(arg >> 8);
+  }
+
+  void key_bpm(accum88 arg) {
+    this->beats->set_bpm(arg);
+    this->update_beat();
+    this->send_update();
+  }
+
+  void key_start_phrase(accum88 arg) {
+    this->beats->start_phrase();
+    this->update_beat();
+    this->send_update();
+  }
+
+  void key_next(accum88 arg) {
+    this->force_next();
+  }
+
+  void key_pattern(accum88 arg) {
+    this->next_state.pattern_phrase = 0;
+    this->next_state.pattern_id = arg >> 8;
+    this->next_state.pattern_sync_id = All;
+    this->update_next();
+  }
+
+  void key_sync_mode(accum88 arg) {
+    this->next_state.pattern_phrase = 0;
+    this->next_state.pattern_id = this->current_state.pattern_id;
+    this->next_state.pattern_sync_id = arg >> 8;
+    this->update_next();
+  }
+
+  void key_palette(accum88 arg) {
+    this->next_state.palette_phrase = 0;
+    this->next_state.palette_id = arg >> 8;
+    this->update_next();
+  }
+
+  void key_effect(accum88 arg) {
+    this->next_state.effect_phrase = 0;
+    this->next_state.effect_params = gEffects[(arg >> 8) % gEffectCount].params;
+    this->update_next();
+  }
+
+  void key_chance(accum88 arg) {
+    this->next_state.effect_phrase = 0;
+    this->next_state.effect_params = this->current_state.effect_params;
+    this->next_state.effect_params.chance = arg;
+    this->update_next();
+  }
+
+  void key_hello(accum88 arg) {
+    // Pretend to receive a HELLO
+    this->onCommand(0, COMMAND_HELLO, NULL);
+  }
+
+  void key_glitter(accum88 arg) {
+    for (int i=0; i< 10; i++)
+      addGlitter();
+  }
+
+  void key_benchmark(accum88 arg) {
+    // Blocks for several seconds
+    benchmark_patterns(this->num_leds);
+    benchmark_checksums();
+    benchmark_noise(MAX_VIRTUAL_LEDS);
+    benchmark_blend(this->num_leds);
+  }
+
+  void key_timing(accum88 arg) {
+    // Dump and restart the task and frame timing stats
+    this->current_state.print();
+    Serial.println();
+    scheduler.print();
+    scheduler.reset();
+#ifdef PROFILING
+    profiler.print();
+    profiler.reset();
+#endif
+  }
+
+  void key_help(accum88 arg) {
+    for (const KeyCommand *k = key_commands; k->key; k++)
+      Serial.println(k->help);
   }
 
   void force_next() {
@@ -681,11 +850,35 @@ class PatternController : public MessageReceiver {
   }
 
   void update_next() {
-    this->radio->sendCommand(COMMAND_NEXT, &this->next_state, sizeof(this->next_state));
+    this->send_state();
   }
 
 };
 
+const KeyCommand PatternController::key_commands[] = {
+  {'b', NumberArg, 60*256, &PatternController::key_bpm, "b###.# - set bpm"},
+  {'s', NoArg, 0, &PatternController::key_start_phrase, "s - start phrase"},
+  {'n', NoArg, 0, &PatternController::key_next, "n - next phrase now"},
+  {'p', NumberArg, 0, &PatternController::key_pattern, "p### - patterns"},
+  {'m', NumberArg, 0, &PatternController::key_sync_mode, "m### - sync mode"},
+  {'c', NumberArg, 0, &PatternController::key_palette, "c### - colors"},
+  {'e', NumberArg, 0, &PatternController::key_effect, "e### - effects"},
+  {'%', NumberArg, 0, &PatternController::key_chance, "%.### - effect chance"},
+  {'i', NumberArg, 0, &PatternController::key_id, "i### - set ID"},
+  {'d', NoArg, 0, &PatternController::key_debugging, "d - toggle debugging"},
+  {'l', NumberArg, 5*256, &PatternController::key_brightness, "l### - brightness"},
+  {'-', RepeatArg, 0, &PatternController::key_dimmer, "--- - dimmer"},
+  {'+', RepeatArg, 0, &PatternController::key_brighter, "+++ - brighter"},
+  {'f', NoArg, 0, &PatternController::key_fireworks, "f - fireworks"},
+  {'g', NoArg, 0, &PatternController::key_glitter, "g - glitter"},
+  {'h', NoArg, 0, &PatternController::key_hello, "h - pretend to hear hello"},
+  {'t', NoArg, 0, &PatternController::key_timing, "t - task and frame timing"},
+  {'B', NoArg, 0, &PatternController::key_benchmark, "B - benchmark patterns, checksums, noise & blending (csv)"},
+  {'?', NoArg, 0, &PatternController::key_help, "? - help"},
+  {0, NoArg, 0, NULL, NULL},
+};
+
+
 
 
 // What's interesting?
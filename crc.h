@@ -0,0 +1,88 @@
+#pragma once
+
+// Checksums for radio packets.
+//
+// crc16() is the reflected CRC-16/CCITT (poly 0x8408, init 0xFFFF), table
+// driven.  RADIO_CRC_SLICES picks how many bytes are folded in per step:
+//   1: one 256-entry table, one lookup per byte
+//   2: two tables, two lookups per two bytes
+//   4: four tables, four lookups per four bytes
+// The tables are built at compile time and live in flash.
+//
+// legacy_crc() is the checksum of earlier firmware: the low 16 bits of a
+// nibble-table CRC-32 that's inverted after every byte.  RADIO_V1_COMPAT
+// sends it, to talk to those tubes.
+
+#ifndef RADIO_CRC_SLICES
+#define RADIO_CRC_SLICES 2
+#endif
+
+#if RADIO_CRC_SLICES != 1 && RADIO_CRC_SLICES != 2 && RADIO_CRC_SLICES != 4
+#error RADIO_CRC_SLICES must be 1, 2 or 4
+#endif
+
+#define CRC16_POLY 0x8408
+#define CRC16_INIT 0xFFFF
+
+class Crc16Tables {
+  public:
+    uint16_t table[RADIO_CRC_SLICES][256];
+
+  constexpr Crc16Tables() : table() {
+    for (uint16_t i = 0; i < 256; i++) {
+      uint16_t crc = i;
+      for (uint8_t bit = 0; bit < 8; bit++)
+        crc = (crc & 1) ? (crc >> 1) ^ CRC16_POLY : crc >> 1;
+      this->table[0][i] = crc;
+    }
+
+    // table[k] advances a byte through k more bytes of zeros
+    for (uint8_t k = 1; k < RADIO_CRC_SLICES; k++) {
+      for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = this->table[k-1][i];
+        this->table[k][i] = (crc >> 8) ^ this->table[0][crc & 0xFF];
+      }
+    }
+  }
+};
+
+constexpr Crc16Tables crc16_tables;
+
+uint16_t crc16(const uint8_t *data, uint8_t len) {
+  const uint16_t (*t)[256] = crc16_tables.table;
+  uint16_t crc = CRC16_INIT;
+
+#if RADIO_CRC_SLICES == 4
+  for (; len >= 4; len -= 4, data += 4) {
+    uint16_t x = crc ^ (data[0] | (data[1] << 8));
+    crc = t[3][x & 0xFF] ^ t[2][x >> 8] ^ t[1][data[2]] ^ t[0][data[3]];
+  }
+#elif RADIO_CRC_SLICES == 2
+  for (; len >= 2; len -= 2, data += 2) {
+    uint16_t x = crc ^ (data[0] | (data[1] << 8));
+    crc = t[1][x & 0xFF] ^ t[0][x >> 8];
+  }
+#endif
+
+  while (len--)
+    crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+  return crc;
+}
+
+uint16_t legacy_crc(const uint8_t *data, uint8_t len) {
+  const static uint32_t crc_table[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+  };
+
+  uint32_t crc = ~0L;
+
+  for (uint8_t index = 0; index < len; ++index) {
+    crc = crc_table[(crc ^ data[index]) & 0x0f] ^ (crc >> 4);
+    crc = crc_table[(crc ^ (data[index] >> 4)) & 0x0f] ^ (crc >> 4);
+    crc = ~crc;
+  }
+  return crc & 65535;
+}
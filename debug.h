@@ -21,13 +21,21 @@ class DebugController {
     this->lastFrame = (uint32_t)-1;
   }
 
-  void update()
+  void printStats()
   {
-    EVERY_N_MILLISECONDS( 10000 ) {
-      Serial.print(F("Free memory: "));
-      Serial.println( freeMemory() );
-    }
+    Serial.print(F("Free memory: "));
+    Serial.println( freeMemory() );
+    paletteCache.print();
+    this->radio->printStats();
+
+    Serial.print(F("Clock error "));
+    Serial.print(this->controller->sync_clock->error);
+    Serial.print(F(" fracs, trim "));
+    Serial.println(this->controller->sync_clock->trim);
+  }
 
+  void update()
+  {
     // Show the beat on the master OR if debugging
 
     if (this->controller->options.debugging) {
@@ -5,44 +5,40 @@
 
 void addGlitter(CRGB color=CRGB::White, PenMode pen=Draw) 
 {
-  addParticle(new Particle(random16(), color, pen, 128));
+  addParticle(random16(), color, pen, 128);
 }
 
 void addSpark(CRGB color=CRGB::White, PenMode pen=Draw) 
 {
-  Particle *particle = new Particle(random16(), color, pen, 64);
+  uint8_t p = addParticle(random16(), color, pen, 64);
   uint8_t r = random8();
   if (r > 128)
-    particle->velocity = r;
+    particles.velocity[p] = r;
   else
-    particle->velocity = -(128 + r);
-  addParticle(particle);
+    particles.velocity[p] = -(128 + r);
 }
 
 void addBeatbox(CRGB color=CRGB::White, PenMode pen=Draw) 
 {
-  Particle *particle = new Particle(random16(), color, pen, 256, drawBeatbox);
-  addParticle(particle);
+  addParticle(random16(), color, pen, 256, BeatboxParticle);
 }
 
 void addBubble(CRGB color=CRGB::White, PenMode pen=Draw) 
 {
-  Particle *particle = new Particle(random16(), color, pen, 1024, drawPop);
-  particle->velocity = random16(0, 40) - 20;
-  addParticle(particle);
+  uint8_t p = addParticle(random16(), color, pen, 1024, PopParticle);
+  particles.velocity[p] = random16(0, 40) - 20;
 }
 
 void addFlash(CRGB color=CRGB::Blue, PenMode pen=Draw) 
 {
-  addParticle(new Particle(random16(), color, pen, 256, drawFlash));
+  addParticle(random16(), color, pen, 256, FlashParticle);
 }
 
 void addDrop(CRGB color, PenMode pen=Draw)
 {
-   Particle *particle = new Particle(65535, color, pen, 360);
-   particle->velocity = -500;
-   particle->gravity = -10;
-   addParticle(particle);
+   uint8_t p = addParticle(65535, color, pen, 360);
+   particles.velocity[p] = -500;
+   particles.gravity[p] = -10;
 }
 
 
@@ -50,26 +46,21 @@ void addDrop(CRGB color, PenMode pen=Draw)
 
 void addFireworkAt(uint16_t pos, CRGB color)
 {
-  Particle *p1 = new Particle(pos, CRGB::White, 20);
-  Particle *p2 = new Particle(pos, CRGB::White, 20);
-  Particle *p3 = new Particle(pos, CRGB::White, 20);
-  p1->velocity = 0;
-  p2->velocity = 40 + random8(40);
-  p3->velocity = -40 - random8(40);
-  addParticle(p1);
-  addParticle(p2);
-  addParticle(p3);
+  uint8_t p1 = addParticle(pos, CRGB::White, Draw, 20);
+  uint8_t p2 = addParticle(pos, CRGB::White, Draw, 20);
+  uint8_t p3 = addParticle(pos, CRGB::White, Draw, 20);
+  particles.velocity[p1] = 0;
+  particles.velocity[p2] = 40 + random8(40);
+  particles.velocity[p3] = -40 - random8(40);
 
   for (int i=0; i<20; i++)
   {
-    Particle *p = new Particle(pos, color, 60);
-    // p->palette = PartyColors_p;
+    uint8_t p = addParticle(pos, color, Draw, 60);
     uint16_t vel = random8();
     if (vel < 128)
-      p->velocity = -2 * vel;
+      particles.velocity[p] = -2 * vel;
     else
-      p->velocity = 2 * (vel - 128);
-    addParticle(p);
+      particles.velocity[p] = 2 * (vel - 128);
   }
 }
 
@@ -83,9 +74,9 @@ void addFirework(fract8 chance)
   addFireworkAt(random16(), color);
 }
 
-void explode(class Particle *particle)
+void explode(uint8_t p)
 {
-  addFireworkAt(particle->position, particle->color);
+  addFireworkAt(particles.position[p], particles.color[p]);
 }
 
 void throwFirework(fract8 chance)
@@ -95,11 +86,9 @@ void throwFirework(fract8 chance)
 
   CRGB color = CHSV(random8(), 255, 255);
   
-  Particle *particle = new Particle(0, color, 100);
-  particle->velocity = 700 + random16(250);
-  particle->gravity = -10;
-  particle->die_fn = explode;
-  addParticle(particle);
+  uint8_t p = addParticle(0, color, Draw, 100);
+  particles.velocity[p] = 700 + random16(250);
+  particles.gravity[p] = -10;
 }
 
 #endif
@@ -158,25 +147,12 @@ class Effects {
   }
 
   void animate(BeatFrame_24_8 frame, uint8_t beat_pulse) {
-    unsigned int len = particles.length();
-    for (unsigned i=len; i > 0; i--) {
-      Particle *particle = particles[i-1];
-  
-      particle->update(frame);
-      if (particle->age > particle->lifetime) {
-        delete particle;
-        particles.erase(i-1);
-        continue;
-      }
-    }
+    particles.animate(frame);
   }
 
-  void draw(CRGB strip[], uint8_t num_leds) {
-    uint8_t len = particles.length();
-    for (uint8_t i=0; i<len; i++) {
-      Particle *particle = particles[i];
-      particle->drawFn(particle, strip, num_leds);
-    }
+  template<class Pixel>
+  void draw(Pixel strip[], uint8_t num_leds) {
+    particles.draw(strip, num_leds);
   }
   
 };
@@ -48,3 +48,89 @@ class TubeState {
   }
 
 };
+
+
+// Wire format of the current and next TubeStates, sent together in one
+// packet.  Fields are packed explicitly (little-endian), so the protocol
+// doesn't depend on struct layout, which differs between boards.
+//   0      format version
+//   1-2    bpm
+//   3-6    beat_frame
+//   7-13   current pattern, sync, palette, effect, pen, beat, chance
+//   14-16  next pattern, palette & effect phrases, relative to the current phrase
+//   17-23  next pattern, sync, palette, effect, pen, beat, chance
+// The current state's phrases aren't sent: they're only used when loading.
+
+#define STATE_WIRE_VERSION 1
+#define STATE_WIRE_SIZE 24
+
+uint8_t phrase_offset(uint16_t next_phrase, uint16_t phrase) {
+  if (next_phrase <= phrase)
+    return 0;
+  return min(next_phrase - phrase, 255);
+}
+
+uint8_t *pack_ids(uint8_t *p, TubeState &state) {
+  *p++ = state.pattern_id;
+  *p++ = state.pattern_sync_id;
+  *p++ = state.palette_id;
+  *p++ = state.effect_params.effect;
+  *p++ = state.effect_params.pen;
+  *p++ = state.effect_params.beat;
+  *p++ = state.effect_params.chance;
+  return p;
+}
+
+const uint8_t *unpack_ids(const uint8_t *p, TubeState &state) {
+  state.pattern_id = *p++;
+  state.pattern_sync_id = *p++;
+  state.palette_id = *p++;
+  state.effect_params.effect = (EffectMode)*p++;
+  state.effect_params.pen = (PenMode)*p++;
+  state.effect_params.beat = (BeatPulse)*p++;
+  state.effect_params.chance = *p++;
+  return p;
+}
+
+uint8_t pack_states(TubeState &current, TubeState &next, uint8_t *buffer) {
+  uint8_t *p = buffer;
+  uint16_t phrase = current.beat_frame >> 12;
+
+  *p++ = STATE_WIRE_VERSION;
+  *p++ = current.bpm;
+  *p++ = current.bpm >> 8;
+  for (uint8_t i = 0; i < 32; i += 8)
+    *p++ = current.beat_frame >> i;
+  p = pack_ids(p, current);
+
+  *p++ = phrase_offset(next.pattern_phrase, phrase);
+  *p++ = phrase_offset(next.palette_phrase, phrase);
+  *p++ = phrase_offset(next.effect_phrase, phrase);
+  p = pack_ids(p, next);
+
+  return p - buffer;
+}
+
+bool unpack_states(const uint8_t *buffer, TubeState &current, TubeState &next) {
+  const uint8_t *p = buffer;
+  if (*p++ != STATE_WIRE_VERSION)
+    return false;
+
+  current.bpm = p[0] | (p[1] << 8);
+  p += 2;
+  current.beat_frame = 0;
+  for (uint8_t i = 0; i < 32; i += 8)
+    current.beat_frame |= (BeatFrame_24_8)*p++ << i;
+  p = unpack_ids(p, current);
+
+  uint16_t phrase = current.beat_frame >> 12;
+  current.pattern_phrase = current.palette_phrase = current.effect_phrase = phrase;
+
+  next.bpm = current.bpm;
+  next.beat_frame = current.beat_frame;
+  next.pattern_phrase = phrase + *p++;
+  next.palette_phrase = phrase + *p++;
+  next.effect_phrase = phrase + *p++;
+  unpack_ids(p, next);
+  return true;
+}
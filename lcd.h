@@ -33,19 +33,52 @@
 
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
+#define LCD_ADDRESS 0x3C
+#define LCD_PAGES (SCREEN_HEIGHT / 8)
+#define LCD_MAX_FIELDS 8
+#define LCD_FIELD_CHARS 11
+#define LCD_CHUNK_BYTES 8    // ~420us per update() at 400KHz, with the address commands
+#define LCD_WIRE_MAX 31      // Wire buffer is 32 bytes, including the control byte
+
+#define SSD1306_COLUMNADDR 0x21
+#define SSD1306_PAGEADDR 0x22
+
+// A text field that was drawn, so unchanged writes can be skipped
+typedef struct {
+  int16_t x;
+  int16_t y;
+  uint8_t size;
+  char text[LCD_FIELD_CHARS];
+} LcdField;
+
+// Text is rendered into the SSD1306 RAM buffer as before, but only the
+// columns of each page that changed are sent, a few bytes per update(),
+// so the main loop is never blocked for a whole frame.
 class Lcd {
   public:
     bool active = 0;
+    uint8_t text_size = 1;
+
+    LcdField fields[LCD_MAX_FIELDS];
+    uint8_t num_fields = 0;
+
+    // Dirty column range per page; clean when start > end
+    uint8_t dirty_start[LCD_PAGES];
+    uint8_t dirty_end[LCD_PAGES];
+    uint8_t next_page = 0;
 
   void setup() {
     this->active = 0;
+    this->num_fields = 0;
+    this->mark_clean();
 
  #ifdef USELCD
     // SSD1306_SWITCHCAPVCC = generate display voltage from 3.3V internally
-    if (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) { // Address 0x3C for 128x64
+    if (!display.begin(SSD1306_SWITCHCAPVCC, LCD_ADDRESS)) { // Address 0x3C for 128x64
       Serial.println(F("LCD: no"));
       return;
     }
+    Wire.setClock(400000);
 
     this->active = 1;
     Serial.println(F("LCD: ok"));
@@ -70,16 +103,20 @@ class Lcd {
     display.clearDisplay();
     display.setTextColor(WHITE, BLACK); // Draw white text on black background
     display.cp437(true);         // Use full 256 char 'Code Page 437' font
+    this->num_fields = 0;
   }
   
   void show() {
-    if (!this->active)
-      return;
-    display.display();
+    // Queue the whole screen; update() sends it in chunks
+    for (uint8_t page = 0; page < LCD_PAGES; page++) {
+      this->dirty_start[page] = 0;
+      this->dirty_end[page] = SCREEN_WIDTH - 1;
+    }
   }
 
   void size(int i) {
     display.setTextSize(i);
+    this->text_size = i;
   }
 
   void write(int x, int y, uint32_t n) {
@@ -101,6 +138,9 @@ class Lcd {
   }
 
   void write(int x, int y, const char buffer[], int size) {
+    if (!this->changed(x, y, buffer, size))
+      return;
+
     display.setCursor(x, y);
     int i = 0;
     while (buffer[i] && i < size) {
@@ -109,9 +149,122 @@ class Lcd {
     while (i++ < size) {
       display.write(' ');
     }
+
+    // Text is 6x8 pixels per character at size 1
+    this->mark_dirty(x, y, x + 6 * this->text_size * size - 1, y + 8 * this->text_size - 1);
+  }
+
+  bool changed(int x, int y, const char buffer[], int size) {
+    LcdField *field = NULL;
+    for (uint8_t i = 0; i < this->num_fields; i++) {
+      if (this->fields[i].x == x && this->fields[i].y == y) {
+        field = &this->fields[i];
+        break;
+      }
+    }
+
+    if (field == NULL) {
+      if (this->num_fields == LCD_MAX_FIELDS)
+        return true;  // Too many fields to track: always redraw
+      field = &this->fields[this->num_fields++];
+      field->x = x;
+      field->y = y;
+      field->size = 0;
+    }
+
+    bool same = field->size == this->text_size && size <= LCD_FIELD_CHARS;
+    bool ended = false;
+    for (int i = 0; i < size && i < LCD_FIELD_CHARS; i++) {
+      // Characters after the terminator are drawn as padding
+      if (!ended && !buffer[i])
+        ended = true;
+      char c = ended ? 0 : buffer[i];
+      if (field->text[i] != c) {
+        field->text[i] = c;
+        same = false;
+      }
+    }
+    field->size = this->text_size;
+    return !same;
+  }
+
+  void mark_clean() {
+    for (uint8_t page = 0; page < LCD_PAGES; page++) {
+      this->dirty_start[page] = SCREEN_WIDTH - 1;
+      this->dirty_end[page] = 0;
+    }
+  }
+
+  void mark_dirty(int x1, int y1, int x2, int y2) {
+    if (x1 < 0)
+      x1 = 0;
+    if (y1 < 0)
+      y1 = 0;
+    if (x2 >= SCREEN_WIDTH)
+      x2 = SCREEN_WIDTH - 1;
+    if (y2 >= SCREEN_HEIGHT)
+      y2 = SCREEN_HEIGHT - 1;
+    if (x1 > x2 || y1 > y2)
+      return;
+
+    for (uint8_t page = y1 / 8; page <= y2 / 8; page++) {
+      if (this->dirty_start[page] > x1)
+        this->dirty_start[page] = x1;
+      if (this->dirty_end[page] < x2)
+        this->dirty_end[page] = x2;
+    }
   }
 
   void update() {
+    if (!this->active)
+      return;
+
+    // Send at most LCD_CHUNK_BYTES of one dirty page per call
+    for (uint8_t n = 0; n < LCD_PAGES; n++) {
+      uint8_t page = this->next_page;
+      if (this->dirty_start[page] <= this->dirty_end[page]) {
+        this->send_chunk(page);
+        return;
+      }
+      this->next_page = (page + 1) % LCD_PAGES;
+    }
+  }
+
+  void send_chunk(uint8_t page) {
+    uint8_t start = this->dirty_start[page];
+    uint8_t end = this->dirty_end[page];
+    if (end - start + 1 > LCD_CHUNK_BYTES)
+      end = start + LCD_CHUNK_BYTES - 1;
+
+    const uint8_t commands[] = {
+      SSD1306_COLUMNADDR, start, end,
+      SSD1306_PAGEADDR, page, page,
+    };
+    this->send(0x00, commands, sizeof(commands));
+
+    // SSD1306 buffer is laid out as one byte per column per page
+    this->send(0x40, display.getBuffer() + page * SCREEN_WIDTH + start, end - start + 1);
+
+    if (end == this->dirty_end[page]) {
+      this->dirty_start[page] = SCREEN_WIDTH - 1;
+      this->dirty_end[page] = 0;
+      this->next_page = (page + 1) % LCD_PAGES;
+    } else {
+      this->dirty_start[page] = end + 1;
+    }
+  }
+
+  void send(uint8_t control, const uint8_t *data, uint8_t len) {
+    while (len) {
+      uint8_t n = min(len, LCD_WIRE_MAX);
+      Wire.beginTransmission(LCD_ADDRESS);
+      Wire.write(control);
+      for (uint8_t i = 0; i < n; i++)
+        Wire.write(data[i]);
+      Wire.endTransmission();
+      data += n;
+      len -= n;
+    }
   }
 };
 
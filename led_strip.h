@@ -1,7 +1,27 @@
 #pragma once
 
+#include "profiler.h"
+
 #define MAX_LEDS    64
+
+// Virtual strips render at VIRTUAL_RATIO (1, 2 or 4) times the resolution
+// of the physical strip, and are resampled down when blended.
+#ifndef VIRTUAL_RATIO
+#ifdef DOUBLED
+#define VIRTUAL_RATIO 2
+#else
+#define VIRTUAL_RATIO 1
+#endif
+#endif
+
+#define VIRTUAL_WIDTH(n)   ((n) * VIRTUAL_RATIO + VIRTUAL_RATIO / 2)
+
+// Always leave room for a doubled strip, which the benchmark renders
+#if VIRTUAL_RATIO > 2
+#define MAX_VIRTUAL_LEDS   VIRTUAL_WIDTH(MAX_LEDS)
+#else
 #define MAX_VIRTUAL_LEDS   (2*MAX_LEDS+1)
+#endif
 
 class LEDs {
   public:
@@ -17,7 +37,7 @@ class LEDs {
     const static int DATA_PIN = 1;
 
     const static int FRAMES_PER_SECOND = 300;  // how often we refresh the strip, in frames per second
-    const static int REFRESH_PERIOD = 1000 / FRAMES_PER_SECOND;  // how often we refresh the strip, in milliseconds
+    const static uint32_t REFRESH_PERIOD = 1000000 / FRAMES_PER_SECOND;  // how often we refresh the strip, in microseconds
     int num_leds;
 
     uint16_t fps = 0;
@@ -46,20 +66,21 @@ class LEDs {
   }
   
   void update(bool reverse=false) {
-    EVERY_N_MILLISECONDS( this->REFRESH_PERIOD ) {
-      // Update the LEDs
-      if (reverse)
-        this->reverse();
-      FastLED.show();
-      this->fps++;
-    }
+    // Called once per frame by the scheduler
+    if (reverse)
+      this->reverse();
+    PROFILE_START(show);
+    FastLED.show();
+    PROFILE_END(show, ProfileShow);
+    this->fps++;
+  }
 
-    EVERY_N_MILLISECONDS( 1000 ) {
-      if (this->fps < (FRAMES_PER_SECOND - 30)) {
-        Serial.print(this->fps);
-        Serial.println((char *)F(" fps!"));
-      }
-      this->fps = 0;
+  void check_fps() {
+    // Called once a second
+    if (this->fps < (FRAMES_PER_SECOND - 30)) {
+      Serial.print(this->fps);
+      Serial.println((char *)F(" fps!"));
     }
+    this->fps = 0;
   }
 };
@@ -0,0 +1,136 @@
+#pragma once
+
+// Binary event log for hot paths (radio packets, state updates), instead of
+// printing text to Serial as things happen.  Logging an event stores a
+// 12-byte record in a ring; flush() writes a few records per call from the
+// scheduler's idle time, one per line as "~" + hex, which
+// tools/decode_log.py turns back into text.  Other Serial output passes
+// through the decoder unchanged.
+//
+// Events below LOG_LEVEL compile out completely.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifdef FASTLED_TEENSYLC
+#define LOG_RING_SIZE 32
+#else
+#define LOG_RING_SIZE 64
+#endif
+
+#define LOG_FLUSH_RECORDS 4   // per flush() call
+
+// Keep in sync with tools/decode_log.py
+typedef enum LogEvent: uint8_t {
+  LogSent=1,           // a=tube, b=command, c=ok
+  LogReceived=2,       // a=tube, b=command, c=relay<<8 | seq
+  LogIgnored=3,        // a=tube, b=LogReason
+  LogCorrupt=4,        // a=tube, b=crc, c=expected crc
+  LogDuplicate=5,      // a=origin, b=seq
+  LogRelayed=6,        // a=origin, b=seq
+  LogUpdateSent=7,     // b=pattern<<8 | palette, c=beat_frame
+  LogUpdateFailed=8,   // a=tube, c=failures
+  LogObeyed=9,         // a=tube, b=pattern<<8 | palette, c=beat_frame
+  LogNext=10,          // a=effect, b=pattern<<8 | palette, c=phrases to the next pattern<<16 | palette<<8 | effect
+  LogClockError=11,    // b=error in fracs, c=tempo trim
+  LogBadFormat=12,     // a=tube, b=format
+  LogSlotMoved=13,     // a=tube heard in our slot, b=new slot
+} LogEvent;
+
+typedef enum LogReason: uint8_t {
+  LogWrongVersion=1,
+  LogRelayedFromMaster=2,
+  LogLowerId=3,
+  LogNotMaster=4,
+} LogReason;
+
+class LogRecord {
+  public:
+    uint32_t micros;
+    uint8_t event;
+    uint8_t a;
+    uint16_t b;
+    uint32_t c;
+};
+
+class Logger {
+  public:
+    LogRecord ring[LOG_RING_SIZE];
+    uint8_t head = 0;
+    uint8_t tail = 0;
+    uint16_t dropped = 0;
+
+  void log(uint8_t event, uint8_t a, uint16_t b, uint32_t c) {
+    if ((uint8_t)(this->head - this->tail) == LOG_RING_SIZE) {
+      this->dropped++;
+      return;
+    }
+
+    LogRecord &record = this->ring[this->head % LOG_RING_SIZE];
+    record.micros = micros();
+    record.event = event;
+    record.a = a;
+    record.b = b;
+    record.c = c;
+    this->head++;
+  }
+
+  void flush() {
+    if (this->dropped) {
+      Serial.print(F("~dropped "));
+      Serial.println(this->dropped);
+      this->dropped = 0;
+    }
+
+    for (uint8_t n = 0; n < LOG_FLUSH_RECORDS && this->tail != this->head; n++) {
+      LogRecord &record = this->ring[this->tail % LOG_RING_SIZE];
+
+      char line[2 + 2 * sizeof(LogRecord) + 1];
+      char *p = line;
+      *p++ = '~';
+      p = this->hex(p, record.micros, 8);
+      p = this->hex(p, record.event, 2);
+      p = this->hex(p, record.a, 2);
+      p = this->hex(p, record.b, 4);
+      p = this->hex(p, record.c, 8);
+      *p = 0;
+      Serial.println(line);
+
+      this->tail++;
+    }
+  }
+
+  char *hex(char *p, uint32_t value, uint8_t digits) {
+    for (int8_t shift = (digits - 1) * 4; shift >= 0; shift -= 4)
+      *p++ = "0123456789abcdef"[(value >> shift) & 0xF];
+    return p;
+  }
+};
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+Logger logger;
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(event, a, b, c) logger.log(event, a, b, c)
+#else
+#define LOG_ERROR(event, a, b, c)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(event, a, b, c) logger.log(event, a, b, c)
+#else
+#define LOG_INFO(event, a, b, c)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(event, a, b, c) logger.log(event, a, b, c)
+#else
+#define LOG_DEBUG(event, a, b, c)
+#endif
@@ -84,8 +84,6 @@ class Master {
       this->taps = 0;
       this->fail();
     }
-
-    this->updateStatus(this->controller, this->controller->led_strip);
   }
 
   void ok() {
@@ -181,7 +179,7 @@ class Master {
       if (this->joystick_active) {
         this->palette_id = pos(gGradientPaletteCount);
         Serial.println(this->palette_id);
-        this->background.palette = gPalettes[this->palette_id];
+        this->background.palette = paletteCache.get(this->palette_id);
       }
     }
   }
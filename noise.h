@@ -0,0 +1,115 @@
+#pragma once
+
+// Gradient noise along a strip, for drawNoise.
+//
+// NoiseRow gives the same values as FastLED's inoise8(x + i*step, y) for
+// i = 0, 1, 2..., but walks the x axis incrementally: y is the same for the
+// whole row, and the four corner gradients of a lattice cell are hashed once
+// per cell rather than once per pixel.  Stepping into the next cell reuses
+// the right-hand corners as the new left-hand ones.  At a step of 17, a cell
+// spans 15 pixels.
+
+// Ken Perlin's permutation, the same one FastLED's noise uses
+const static uint8_t noise_perm[256] = {
+  151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+  140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+  247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+  57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+  74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+  60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+  65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+  200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+  52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+  207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+  119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+  129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+  218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+  81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+  184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+  222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180,
+};
+
+// Dot product of a hashed gradient with (x, y), as FastLED's grad8
+inline int8_t noise_grad8(uint8_t hash, int8_t x, int8_t y) {
+  int8_t u = x, v = y;
+  if (hash & 4) {
+    u = y;
+    v = x;
+  }
+  if (hash & 1)
+    u = -u;
+  if (hash & 2)
+    v = -v;
+  return avg7(u, v);
+}
+
+// Signed 7-bit lerp, as FastLED's lerp7by8 (which is private to noise.cpp)
+inline int8_t noise_lerp7by8(int8_t a, int8_t b, fract8 frac) {
+  if (b > a) {
+    uint8_t delta = b - a;
+    return a + scale8(delta, frac);
+  } else {
+    uint8_t delta = a - b;
+    return a - scale8(delta, frac);
+  }
+}
+
+class NoiseRow {
+  public:
+    uint16_t x;
+    uint16_t step;
+    uint8_t cell;
+
+    // Row constants
+    uint8_t y_cell;
+    int8_t yy;
+    uint8_t v;
+
+    // Corner hashes of the current cell: left/right, bottom/top
+    uint8_t left0, left1;
+    uint8_t right0, right1;
+
+  NoiseRow(uint16_t x, uint16_t step, uint16_t y) {
+    this->x = x;
+    this->step = step;
+    this->y_cell = y >> 8;
+    this->yy = (uint8_t)y >> 1;
+    this->v = ease8InOutQuad(y);
+
+    this->cell = x >> 8;
+    this->corner(this->cell, this->left0, this->left1);
+    this->corner(this->cell + 1, this->right0, this->right1);
+  }
+
+  void corner(uint8_t X, uint8_t &hash0, uint8_t &hash1) {
+    uint8_t a = noise_perm[X] + this->y_cell;
+    hash0 = noise_perm[noise_perm[a]];
+    hash1 = noise_perm[noise_perm[(uint8_t)(a + 1)]];
+  }
+
+  // The next value along the row, from 0 to 255
+  uint8_t next() {
+    uint8_t cell = this->x >> 8;
+    if (cell != this->cell) {
+      if (cell == (uint8_t)(this->cell + 1)) {
+        this->left0 = this->right0;
+        this->left1 = this->right1;
+      } else {
+        this->corner(cell, this->left0, this->left1);
+      }
+      this->corner(cell + 1, this->right0, this->right1);
+      this->cell = cell;
+    }
+
+    uint8_t fx = this->x;
+    int8_t xx = fx >> 1;
+    uint8_t u = ease8InOutQuad(fx);
+    this->x += this->step;
+
+    const uint8_t N = 0x80;
+    int8_t x1 = noise_lerp7by8(noise_grad8(this->left0, xx, this->yy), noise_grad8(this->right0, xx - N, this->yy), u);
+    int8_t x2 = noise_lerp7by8(noise_grad8(this->left1, xx, this->yy - N), noise_grad8(this->right1, xx - N, this->yy - N), u);
+    int8_t n = noise_lerp7by8(x1, x2, this->v) + 64;
+    return qadd8(n, n);
+  }
+};
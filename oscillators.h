@@ -0,0 +1,94 @@
+#pragma once
+
+// Low-frequency oscillators, driven by the shared beat clock instead of
+// millis(), so every tube in sync drifts and pulses in step.  All of them are
+// computed once per frame by update(); patterns just read the values.
+//
+// Rates are in cycles per 256 beats: at 120bpm, a rate of 256 is 2Hz.
+
+typedef enum Waveform: uint8_t {
+  SineWave=0,
+  TriangleWave=1,
+  SawWave=2,
+} Waveform;
+
+typedef enum OscillatorId: uint8_t {
+  DriftOscillator=0,    // SinDrift and SwingDrift
+  PulseOscillator=1,    // Pulse
+  JuggleOscillator=2,   // 8 of them, for juggle's dots
+} OscillatorId;
+
+#define NUM_OSCILLATORS 10
+
+// One quadrant of a sine wave, in 64 steps
+const static int16_t quarter_sine[65] = {
+  0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+  6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767,
+};
+
+// Sine of a 16-bit phase, from 0 to 65535 like beatsin16
+uint16_t sine16(uint16_t phase) {
+  uint16_t x = phase & 0x3FFF;
+  if (phase & 0x4000)
+    x = 0x4000 - x;
+
+  uint8_t i = x >> 8;
+  int16_t s = quarter_sine[i];
+  if (i < 64)
+    s += ((quarter_sine[i+1] - s) * (x & 0xFF)) >> 8;
+
+  return (phase & 0x8000) ? 32768 - s : 32768 + s;
+}
+
+class OscillatorBank {
+  public:
+    uint16_t rate[NUM_OSCILLATORS];
+    Waveform wave[NUM_OSCILLATORS];
+    uint16_t value[NUM_OSCILLATORS];
+
+  OscillatorBank() {
+    // Roughly the millis() rates these replace, at 120bpm
+    this->set(DriftOscillator, 11);
+    this->set(PulseOscillator, 21);
+    for (uint8_t i = 0; i < 8; i++)
+      this->set(JuggleOscillator + i, 15 + 2*i);
+  }
+
+  void set(uint8_t id, uint16_t rate, Waveform wave=SineWave) {
+    this->rate[id] = rate;
+    this->wave[id] = wave;
+    this->value[id] = 0;
+  }
+
+  void update(BeatFrame_24_8 frame) {
+    for (uint8_t i = 0; i < NUM_OSCILLATORS; i++) {
+      uint16_t phase = frame * this->rate[i];
+      switch (this->wave[i]) {
+        case SineWave:
+          this->value[i] = sine16(phase);
+          break;
+
+        case TriangleWave:
+          this->value[i] = (phase & 0x8000) ? ~(phase << 1) : phase << 1;
+          break;
+
+        case SawWave:
+          this->value[i] = phase;
+          break;
+      }
+    }
+  }
+
+  uint16_t scaled(uint8_t id, uint16_t low, uint16_t high) {
+    return low + scale16(this->value[id], high - low);
+  }
+};
+
+OscillatorBank oscillators;
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "palette.h"
+
+#define PALETTE_CACHE_SIZE 4
+
+// Recently decoded gradient palettes, keyed by palette_id.  Shared by the
+// controller and the master's palette picker, so switching back to a recent
+// palette, or scrolling through them, doesn't decode the gradient again.
+class PaletteCache {
+  public:
+    CRGBPalette16 palettes[PALETTE_CACHE_SIZE];
+    uint8_t ids[PALETTE_CACHE_SIZE];
+    uint32_t last_used[PALETTE_CACHE_SIZE];
+    uint8_t size = 0;
+    uint32_t clock = 0;
+
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+
+  const CRGBPalette16 &get(uint8_t palette_id) {
+    this->clock++;
+
+    for (uint8_t i = 0; i < this->size; i++) {
+      if (this->ids[i] == palette_id) {
+        this->hits++;
+        this->last_used[i] = this->clock;
+        return this->palettes[i];
+      }
+    }
+
+    this->misses++;
+    uint8_t slot = this->size;
+    if (this->size < PALETTE_CACHE_SIZE) {
+      this->size++;
+    } else {
+      // Evict the least recently used palette
+      slot = 0;
+      for (uint8_t i = 1; i < this->size; i++) {
+        if (this->clock - this->last_used[i] > this->clock - this->last_used[slot])
+          slot = i;
+      }
+    }
+
+    this->ids[slot] = palette_id;
+    this->palettes[slot] = gPalettes[palette_id];
+    this->last_used[slot] = this->clock;
+    return this->palettes[slot];
+  }
+
+  void print() {
+    Serial.print(F("Palette cache: "));
+    Serial.print(this->hits);
+    Serial.print(F(" hits, "));
+    Serial.print(this->misses);
+    Serial.println(F(" misses"));
+  }
+};
+
+PaletteCache paletteCache;
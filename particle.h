@@ -1,219 +1,309 @@
 #pragma once
 
+#include "accum.h"
+
 #define MAX_PARTICLES 20
-#undef PARTICLE_PALETTES
 
-class Particle;
+// How a particle is rendered.  Particles are drawn grouped by kind.
+typedef enum ParticleKind: uint8_t {
+  PointParticle=0,
+  FlashParticle=1,
+  PopParticle=2,
+  BeatboxParticle=3,
+} ParticleKind;
+
+#define PARTICLE_KINDS 4
+
+uint16_t udelta16(uint16_t x, int16_t dx)
+{
+  if (dx > 0 && 65535-x < dx)
+    return 65335;
+  if (dx < 0 && x < -dx)
+    return 0;
+  return x + dx;
+}
 
-typedef void (*ParticleFn)(Particle *particle, CRGB strip[], uint8_t num_leds);
+int16_t delta16(int16_t x, int16_t dx)
+{
+  if (dx > 0 && 32767-x < dx)
+    return 32767;
+  if (dx < 0 && x < -32767 - dx)
+    return -32767;
+  return x + dx;
+}
 
-extern void drawPoint(Particle *particle, CRGB strip[], uint8_t num_leds);
-extern void drawFlash(Particle *particle, CRGB strip[], uint8_t num_leds);
+void draw_with_pen(CRGB strip[], int pos, CRGB color, PenMode pen) {
+  CRGB new_color;
 
+  switch (pen) {
+    case Draw:
+      strip[pos] = color;
+      break;
 
-class Particle {
-  const static uint16_t DEFAULT_BRIGHTNESS = (192<<8); // or 96
+    case Blend:
+      strip[pos] |= color;
+      break;
 
-  public:
-    BeatFrame_24_8 born;
-    BeatFrame_24_8 lifetime;
-    BeatFrame_24_8 age;
-
-    uint16_t position = 0;
-    int16_t velocity = 0;
-    int16_t gravity = 0;
-    void (*die_fn)(Particle *particle) = NULL;
-    PenMode pen = Draw;
-
-#ifdef PARTICLE_PALETTES
-    CRGBPalette16 palette;   // 48 bytes per particle!?
-#endif
+    case Erase:
+      strip[pos] &= color;
+      break;
 
-    CRGB color;
-    uint16_t brightness;
-    ParticleFn drawFn;
-
-  Particle(uint16_t position, CRGB color=CRGB::White, PenMode pen=Draw, uint32_t lifetime=20000, ParticleFn drawFn=drawPoint)
-  {
-    this->age = 0;
-    this->position = position;
-    this->color = color;
-    this->pen = pen;
-    this->lifetime = lifetime;
-    this->brightness = DEFAULT_BRIGHTNESS;
-    this->drawFn = drawFn;
-  }
+    case Invert:
+      strip[pos] = -strip[pos];
+      break;
 
-  void update(BeatFrame_24_8 frame)
-  {
-    this->age = frame - this->born;
-    this->position = this->udelta16(this->position, this->velocity);
-    this->velocity = this->delta16(this->velocity, this->gravity);
-  }
+    case Brighten: {
+      uint8_t t = color.getAverageLight();
+      new_color = CRGB(t,t,t);
+      strip[pos] += new_color;
+      break;
+    }
 
-  uint16_t age_frac16(BeatFrame_24_8 age)
-  {
-    if (age >= this->lifetime)
-      return 65535;
-    uint32_t a = age * 65536;
-    return a / this->lifetime;
-  }
+    case Darken: {
+      uint8_t t = color.getAverageLight();
+      new_color = CRGB(t,t,t);
+      strip[pos] -= new_color;
+      break;
+    }
 
-  uint16_t udelta16(uint16_t x, int16_t dx)
-  {
-    if (dx > 0 && 65535-x < dx)
-      return 65335;
-    if (dx < 0 && x < -dx)
-      return 0;
-    return x + dx;
-  }
-  
-  int16_t delta16(int16_t x, int16_t dx)
-  {
-    if (dx > 0 && 32767-x < dx)
-      return 32767;
-    if (dx < 0 && x < -32767 - dx)
-      return -32767;
-    return x + dx;
-  }
+    case Flicker: {
+      uint8_t t = color.getAverageLight();
+      new_color = CRGB(t,t,t);
+      if (millis() % 2)
+        strip[pos] -= new_color;
+      else
+        strip[pos] += new_color;
+      break;
+    }
 
-  CRGB color_at(uint16_t age_frac) {
-    // Particles get dimmer with age
-    uint8_t a = age_frac >> 8;
-    uint8_t brightness = scale8((uint8_t)(this->brightness>>8), 255-a);
+    case White:
+      strip[pos] = CRGB::White;
+      break;
 
-#ifdef PARTICLE_PALETTES
-    // a black pattern actually means to use the current palette
-    if (this->color == CRGB(0,0,0))
-      return ColorFromPalette(this->palette, a, brightness);
-#endif
+    case Black:
+      strip[pos] = CRGB::Black;
+      break;
 
-    uint8_t r = scale8(this->color.r, brightness);
-    uint8_t g = scale8(this->color.g, brightness);
-    uint8_t b = scale8(this->color.b, brightness);
-    return CRGB(r,g,b);
   }
+}
 
-  void draw_with_pen(CRGB strip[], int pos, CRGB color) {
-    CRGB new_color;
-    
-    switch (this->pen) {
-      case Draw:  
-        strip[pos] = color;
-        break;
-  
-      case Blend:
-        strip[pos] |= color;
-        break;
-  
-      case Erase:
-        strip[pos] &= color;
-        break;
-  
-      case Invert:
-        strip[pos] = -strip[pos];
-        break;  
-
-      case Brighten: {
-        uint8_t t = color.getAverageLight();
-        new_color = CRGB(t,t,t);
-        strip[pos] += new_color;
-        break;  
-      }
+#ifdef HDR_BUFFER
+// The same pens, drawing into the 16-bit buffer
+void draw_with_pen(RGB16 strip[], int pos, CRGB color, PenMode pen) {
+  RGB16 &p = strip[pos];
+  uint16_t r = expand8(color.r), g = expand8(color.g), b = expand8(color.b);
+  uint16_t t = expand8(color.getAverageLight());
+
+  switch (pen) {
+    case Draw:
+      p.r = r;
+      p.g = g;
+      p.b = b;
+      break;
+
+    case Blend:
+      accum_max(p, r, g, b);
+      break;
+
+    case Erase:
+      // As CRGB's &=, the darker of each channel
+      if (r < p.r) p.r = r;
+      if (g < p.g) p.g = g;
+      if (b < p.b) p.b = b;
+      break;
+
+    case Invert:
+      p.r = 65535 - p.r;
+      p.g = 65535 - p.g;
+      p.b = 65535 - p.b;
+      break;
+
+    case Brighten:
+      accum_add(p, t, t, t);
+      break;
+
+    case Darken:
+      accum_sub(p, t, t, t);
+      break;
+
+    case Flicker:
+      if (millis() % 2)
+        accum_sub(p, t, t, t);
+      else
+        accum_add(p, t, t, t);
+      break;
+
+    case White:
+      p.r = p.g = p.b = 65535;
+      break;
+
+    case Black:
+      p.r = p.g = p.b = 0;
+      break;
+  }
+}
+#endif
 
-      case Darken: {
-        uint8_t t = color.getAverageLight();
-        new_color = CRGB(t,t,t);
-        strip[pos] -= new_color;
-        break;  
-      }
+// Particle state is kept as parallel arrays, packed into [0, num_live).
+// animate() ages, moves and colors every particle in one pass; draw() then
+// renders them one kind at a time, so there is no per-particle indirect call.
+class ParticleSystem {
+  const static uint8_t DEFAULT_BRIGHTNESS = 192; // or 96
 
-      case Flicker: {
-        uint8_t t = color.getAverageLight();
-        new_color = CRGB(t,t,t);
-        if (millis() % 2)
-          strip[pos] -= new_color;
-        else
-          strip[pos] += new_color;
-        break;  
-      }
+  public:
+    uint8_t num_live = 0;
+
+    BeatFrame_24_8 born[MAX_PARTICLES];
+    BeatFrame_24_8 lifetime[MAX_PARTICLES];
+    BeatFrame_24_8 age[MAX_PARTICLES];
+    uint16_t position[MAX_PARTICLES];
+    int16_t velocity[MAX_PARTICLES];
+    int16_t gravity[MAX_PARTICLES];
+    CRGB color[MAX_PARTICLES];
+    PenMode pen[MAX_PARTICLES];
+    ParticleKind kind[MAX_PARTICLES];
+
+    // Computed by animate() for draw()
+    uint16_t age_frac[MAX_PARTICLES];
+    CRGB draw_color[MAX_PARTICLES];
+
+  uint8_t length() {
+    return this->num_live;
+  }
 
-      case White:
-        strip[pos] = CRGB::White;
-        break;  
+  uint8_t add(BeatFrame_24_8 frame, uint16_t position, CRGB color, PenMode pen, uint32_t lifetime, ParticleKind kind) {
+    if (this->num_live == MAX_PARTICLES)
+      this->release(this->oldest(frame));
+
+    uint8_t i = this->num_live++;
+    this->born[i] = frame;
+    this->lifetime[i] = lifetime;
+    this->age[i] = 0;
+    this->position[i] = position;
+    this->velocity[i] = 0;
+    this->gravity[i] = 0;
+    this->color[i] = color;
+    this->pen[i] = pen;
+    this->kind[i] = kind;
+    this->age_frac[i] = 0;
+    this->draw_color[i] = CRGB::Black;
+    return i;
+  }
 
-      case Black:
-        strip[pos] = CRGB::Black;
-        break;  
+  void release(uint8_t i) {
+    // Swap-remove: move the last particle into the hole
+    uint8_t last = --this->num_live;
+    if (i == last)
+      return;
+
+    this->born[i] = this->born[last];
+    this->lifetime[i] = this->lifetime[last];
+    this->age[i] = this->age[last];
+    this->position[i] = this->position[last];
+    this->velocity[i] = this->velocity[last];
+    this->gravity[i] = this->gravity[last];
+    this->color[i] = this->color[last];
+    this->pen[i] = this->pen[last];
+    this->kind[i] = this->kind[last];
+    this->age_frac[i] = this->age_frac[last];
+    this->draw_color[i] = this->draw_color[last];
+  }
 
+  uint8_t oldest(BeatFrame_24_8 frame) {
+    // Only needed when the pool overflows
+    uint8_t oldest = 0;
+    for (uint8_t i = 1; i < this->num_live; i++) {
+      if (frame - this->born[i] > frame - this->born[oldest])
+        oldest = i;
     }
+    return oldest;
   }
 
-};
-
-ustd::array<Particle*> particles = ustd::array<Particle*>(5);
-BeatFrame_24_8 particle_beat_frame;
+  void animate(BeatFrame_24_8 frame) {
+    for (uint8_t i = this->num_live; i > 0; i--) {
+      uint8_t p = i-1;
+      BeatFrame_24_8 age = frame - this->born[p];
+      BeatFrame_24_8 lifetime = this->lifetime[p];
+      if (age > lifetime) {
+        this->release(p);
+        continue;
+      }
 
-void addParticle(Particle *particle) {
-  particle->born = particle_beat_frame;
-  particles.add(particle);
-  if (particles.length() > MAX_PARTICLES) {
-    Particle *old_particle = particles[0];
-    delete old_particle;
-    particles.erase(0);
-  }
-}
+      this->age[p] = age;
+      this->position[p] = udelta16(this->position[p], this->velocity[p]);
+      this->velocity[p] = delta16(this->velocity[p], this->gravity[p]);
 
+      // Particles get dimmer with age
+      uint16_t age_frac = (age >= lifetime) ? 65535 : (age * 65536) / lifetime;
+      uint8_t brightness = scale8(DEFAULT_BRIGHTNESS, 255 - (age_frac >> 8));
+      CRGB c = this->color[p];
+      nscale8x3(c.r, c.g, c.b, brightness);
 
-void drawFlash(Particle *particle, CRGB strip[], uint8_t num_leds) {
-  uint16_t age_frac = particle->age_frac16(particle->age);
-  CRGB c = particle->color_at(age_frac);
-  for (int pos = 0; pos < num_leds; pos++) {
-    particle->draw_with_pen(strip, pos, c);
+      this->age_frac[p] = age_frac;
+      this->draw_color[p] = c;
+    }
   }
-}
 
-void drawPoint(Particle *particle, CRGB strip[], uint8_t num_leds) {
-  uint16_t age_frac = particle->age_frac16(particle->age);
-  CRGB c = particle->color_at(age_frac);
-
-  uint16_t pos = scale16(particle->position, num_leds-1);
-  particle->draw_with_pen(strip, pos, c);
-}
+  // Draws into a CRGB strip, or an RGB16 buffer
+  template<class Pixel>
+  void draw(Pixel strip[], uint8_t num_leds) {
+    for (uint8_t k = 0; k < PARTICLE_KINDS; k++) {
+      for (uint8_t p = 0; p < this->num_live; p++) {
+        if (this->kind[p] != k)
+          continue;
+
+        // Locals, since writes to the strip could alias the arrays
+        uint16_t pos = scale16(this->position[p], num_leds-1);
+        CRGB c = this->draw_color[p];
+        PenMode pen = this->pen[p];
+        switch (k) {
+          case PointParticle:
+            draw_with_pen(strip, pos, c, pen);
+            break;
+
+          case FlashParticle:
+            for (int i = 0; i < num_leds; i++)
+              draw_with_pen(strip, i, c, pen);
+            break;
+
+          case PopParticle: {
+            uint8_t radius = scale16((sin16(this->age_frac[p]/2) - 32768) * 2, 8);
+            drawRadius(strip, num_leds, pos, radius, c, pen, true);
+            break;
+          }
+
+          case BeatboxParticle:
+            drawRadius(strip, num_leds, pos, 5, c, pen, false);
+            break;
+        }
+      }
+    }
+  }
 
-void drawRadius(Particle *particle, CRGB strip[], uint8_t num_leds, uint16_t pos, uint8_t radius, CRGB c, bool dim=true) {
-  for (int i = 0; i < radius; i++) {
-    uint8_t bright = dim ? ((radius-i) * 255) / radius : 255;
-    nscale8(&c, 1, bright);
+  template<class Pixel>
+  static void drawRadius(Pixel strip[], uint8_t num_leds, uint16_t pos, uint8_t radius, CRGB c, PenMode pen, bool dim) {
+    for (int i = 0; i < radius; i++) {
+      uint8_t bright = dim ? ((radius-i) * 255) / radius : 255;
+      nscale8(&c, 1, bright);
 
-    uint8_t y = pos - i;
-    if (y >= 0 && y < num_leds)
-      particle->draw_with_pen(strip, y, c);
+      uint8_t y = pos - i;
+      if (y >= 0 && y < num_leds)
+        draw_with_pen(strip, y, c, pen);
 
-    if (i == 0)
-      continue;
+      if (i == 0)
+        continue;
 
-    y = pos + i;
-    if (y >= 0 && y < num_leds)
-      particle->draw_with_pen(strip, y, c);
+      y = pos + i;
+      if (y >= 0 && y < num_leds)
+        draw_with_pen(strip, y, c, pen);
+    }
   }
-}
-
-void drawPop(Particle *particle, CRGB strip[], uint8_t num_leds) {
-  uint16_t age_frac = particle->age_frac16(particle->age);
-  CRGB c = particle->color_at(age_frac);
-  uint16_t pos = scale16(particle->position, num_leds-1);
-  uint8_t radius = scale16((sin16(age_frac/2) - 32768) * 2, 8);
 
-  drawRadius(particle, strip, num_leds, pos, radius, c);
-}
+};
 
-void drawBeatbox(Particle *particle, CRGB strip[], uint8_t num_leds) {
-  uint16_t age_frac = particle->age_frac16(particle->age);
-  CRGB c = particle->color_at(age_frac);
-  uint16_t pos = scale16(particle->position, num_leds-1);
-  uint8_t radius = 5;
+ParticleSystem particles;
+BeatFrame_24_8 particle_beat_frame;
 
-  drawRadius(particle, strip, num_leds, pos, radius, c, false);
+uint8_t addParticle(uint16_t position, CRGB color=CRGB::White, PenMode pen=Draw, uint32_t lifetime=20000, ParticleKind kind=PointParticle) {
+  return particles.add(particle_beat_frame, position, color, pen, lifetime, kind);
 }
-
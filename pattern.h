@@ -2,36 +2,42 @@
 
 #include "palette.h"
 #include "virtual_strip.h"
+#include "noise.h"
 
+// Patterns that draw colors from outside the strip's palette can't run on
+// indexed strips.
+#ifndef INDEXED_VSTRIPS
 void rainbow(VirtualStrip *strip) 
 {
   // FastLED's built-in rainbow generator
   fill_rainbow( strip->leds, strip->num_leds, strip->hue, 3);
 }
+#endif
 
 void palette_wave(VirtualStrip *strip) 
 {
   // FastLED's built-in rainbow generator
   uint8_t hue = strip->hue;
-  for (uint8_t i=0; i < strip->num_leds; i++) {
-    CRGB c = strip->palette_color(i, hue);
-    nscale8x3(c.r, c.g, c.b, sin8(hue*8));
-    strip->leds[i] = c;
+  for (uint16_t i=0; i < strip->num_leds; i++) {
+    strip->paint(i, i, hue, sin8(hue*8));
     hue++;
   }
 }
 
 void particleTest(VirtualStrip *strip)
 {
-  fill_solid( strip->leds, strip->num_leds, CRGB::Black);
-  fill_solid( strip->leds, 2, strip->palette_color(0, strip->hue));
+  strip->clear();
+  strip->paint(0, 0, strip->hue);
+  strip->paint(1, 0, strip->hue);
 }
 
 void solidBlack(VirtualStrip *strip)
 {
-  fill_solid( strip->leds, strip->num_leds, CRGB::Black);
+  strip->clear();
 }
 
+#ifndef INDEXED_VSTRIPS
+
 void solidWhite(VirtualStrip *strip) 
 {
   fill_solid( strip->leds, strip->num_leds, CRGB::White);
@@ -46,13 +52,14 @@ void solidBlue(VirtualStrip *strip)
 {
   fill_solid( strip->leds, strip->num_leds, CRGB::Blue);
 }
+#endif
 
 void confetti(VirtualStrip *strip) 
 {
   strip->darken(2);
   
   int pos = random16(strip->num_leds);
-  strip->leds[pos] += strip->palette_color(random8(64), strip->hue);
+  strip->add(pos, random8(64), strip->hue);
 }
 
 uint16_t random_offset = random16();
@@ -65,8 +72,8 @@ void biwave(VirtualStrip *strip)
   uint16_t r = strip->frame * 32;
   r = cos16( r + random_offset ) + 32768;
 
-  uint8_t p1 = scaled16to8(l, 0, strip->num_leds-1);
-  uint8_t p2 = scaled16to8(r, 0, strip->num_leds-1);
+  uint16_t p1 = scale16(l, strip->num_leds-1);
+  uint16_t p2 = scale16(r, strip->num_leds-1);
   
   if (p2 < p1) {
     uint16_t t = p1;
@@ -74,12 +81,13 @@ void biwave(VirtualStrip *strip)
     p2 = t;
   }
 
-  strip->fill(CRGB::Black);
+  strip->clear();
   for (uint16_t p = p1; p <= p2; p++) {
-    strip->leds[p] = strip->palette_color(p*2, strip->hue*3);
+    strip->paint(p, p*2, strip->hue*3);
   }
 }
 
+#ifndef INDEXED_VSTRIPS
 void sinelon(VirtualStrip *strip) 
 {
   // a colored dot sweeping back and forth, with fading trails
@@ -88,17 +96,17 @@ void sinelon(VirtualStrip *strip)
   int pos = scale16(sin16( strip->frame << 5 ) + 32768, strip->num_leds-1);   // beatsin16 re-implemented
   strip->leds[pos] += strip->hue_color();
 }
+#endif
 
 void bpm_palette(VirtualStrip *strip) 
 {
   uint8_t beat = strip->bpm_sin16(64, 255);
   for (int i = 0; i < strip->num_leds; i++) {
-    CRGB c = strip->palette_color(i*2, strip->hue);
-    nscale8x3(c.r, c.g, c.b, beat-strip->hue+(i*10));
-    strip->leds[i] = c;
+    strip->paint(i, i*2, strip->hue, beat-strip->hue+(i*10));
   }
 }
 
+#ifndef INDEXED_VSTRIPS
 void bpm(VirtualStrip *strip) 
 {
   // colored stripes pulsing at a defined Beats-Per-Minute (BPM)
@@ -109,6 +117,7 @@ void bpm(VirtualStrip *strip)
     strip->leds[i] = ColorFromPalette(palette, strip->hue+(i*2), beat-strip->hue+(i*10));
   }
 }
+#endif
 
 void juggle(VirtualStrip *strip) 
 {
@@ -117,41 +126,37 @@ void juggle(VirtualStrip *strip)
 
   byte dothue = 0;
   for( int i = 0; i < 8; i++) {
-    CRGB c = strip->palette_color(dothue + strip->hue);
-    // c = CHSV(dothue, 200, 255);
-    strip->leds[beatsin16( i+7, 0, strip->num_leds-1 )] |= c;
+    strip->lighten(oscillators.scaled(JuggleOscillator + i, 0, strip->num_leds-1), dothue, strip->hue);
     dothue += 32;
   }
 }
 
-uint8_t noise[MAX_VIRTUAL_LEDS];
-
-void fillnoise8(uint32_t frame, uint8_t num_leds) {
+void fillnoise8(VirtualStrip *strip, uint32_t frame) {
   uint16_t scale = 17;
   uint8_t dataSmoothing = 240;
-  
-  for (int i = 0; i < num_leds; i++) {
-    uint8_t data = inoise8(i * scale, frame>>2);
+  NoiseRow row(0, scale, frame>>2);
+
+  for (int i = 0; i < strip->num_leds; i++) {
+    uint8_t data = row.next();
 
     // The range of the inoise8 function is roughly 16-238.
     // These two operations expand those values out to roughly 0..255
     data = qsub8(data,16);
     data = qadd8(data,scale8(data,39));
 
-    uint8_t olddata = noise[i];
+    uint8_t olddata = strip->noise[i];
     uint8_t newdata = scale8( olddata, dataSmoothing) + scale8( data, 256 - dataSmoothing);
-    noise[i] = newdata;
+    strip->noise[i] = newdata;
   }
 }
 
 void drawNoise(VirtualStrip *strip)
 {
   // generate noise data
-  fillnoise8(strip->frame >> 2, strip->num_leds);
+  fillnoise8(strip, strip->frame >> 2);
 
   for(int i = 0; i < strip->num_leds; i++) {
-    CRGB color = strip->palette_color(noise[i], strip->hue);
-    strip->leds[i] = color;
+    strip->paint(i, strip->noise[i], strip->hue);
   }
 }
 
@@ -170,13 +175,22 @@ PatternDef gPatterns[] = {
   {drawNoise, {MediumDuration}},
   {drawNoise, {LongDuration}},
   {drawNoise, {LongDuration}},
+#ifndef INDEXED_VSTRIPS
   {rainbow, {ShortDuration}},
+#else
+  {palette_wave, {ShortDuration}},  // stand-in, so pattern ids still match other tubes
+#endif
   {confetti, {ShortDuration}},
   {confetti, {MediumDuration}},
 
   {juggle, {ShortDuration}},
+#ifndef INDEXED_VSTRIPS
   {bpm, {ShortDuration}},
   {bpm, {MediumDuration, HighEnergy}},
+#else
+  {bpm_palette, {ShortDuration}},
+  {bpm_palette, {MediumDuration, HighEnergy}},
+#endif
   {palette_wave, {ShortDuration}},
   {palette_wave, {MediumDuration}},
   {bpm_palette, {ShortDuration}},
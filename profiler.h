@@ -0,0 +1,132 @@
+#pragma once
+
+// Per-stage timing of the main loop.  Define PROFILING to collect it;
+// otherwise the PROFILE_* macros compile to nothing.
+
+typedef enum ProfileStage: uint8_t {
+  ProfileBeats=0,
+  ProfileRadio=1,
+  ProfileAnimate=2,
+  ProfileBlend=3,
+  ProfileEffectsAnimate=4,
+  ProfileEffectsDraw=5,
+  ProfileShow=6,
+  ProfileDebug=7,
+  ProfileQuantize=8,
+} ProfileStage;
+
+#define PROFILE_STAGES 9
+#define PROFILE_RING_SIZE 16   // most recent samples per stage
+#define PROFILE_BUCKETS 16     // log2 buckets: 0us, 1us, 2-3us, 4-7us ... 16384us+
+
+class StageProfile {
+  public:
+    uint16_t ring[PROFILE_RING_SIZE];
+    uint8_t ring_pos;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total;
+    uint32_t samples;
+    uint16_t histogram[PROFILE_BUCKETS];
+
+  void reset() {
+    memset(this, 0, sizeof(*this));
+    this->min = (uint32_t)-1;
+  }
+
+  void record(uint32_t micros) {
+    this->ring[this->ring_pos] = micros > 65535 ? 65535 : micros;
+    this->ring_pos = (this->ring_pos + 1) % PROFILE_RING_SIZE;
+
+    if (micros < this->min)
+      this->min = micros;
+    if (micros > this->max)
+      this->max = micros;
+    this->total += micros;
+    this->samples++;
+
+    uint8_t bucket = micros ? 32 - __builtin_clz(micros) : 0;
+    if (bucket >= PROFILE_BUCKETS)
+      bucket = PROFILE_BUCKETS - 1;
+    if (this->histogram[bucket] < 65535)
+      this->histogram[bucket]++;
+  }
+
+  uint32_t recent_max() {
+    uint16_t m = 0;
+    for (uint8_t i = 0; i < PROFILE_RING_SIZE; i++) {
+      if (this->ring[i] > m)
+        m = this->ring[i];
+    }
+    return m;
+  }
+};
+
+class Profiler {
+  public:
+    StageProfile stages[PROFILE_STAGES];
+
+  Profiler() {
+    this->reset();
+  }
+
+  void reset() {
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++)
+      this->stages[i].reset();
+  }
+
+  void record(ProfileStage stage, uint32_t micros) {
+    this->stages[stage].record(micros);
+  }
+
+  const __FlashStringHelper *stage_name(uint8_t stage) {
+    switch (stage) {
+      case ProfileBeats: return F("beats");
+      case ProfileRadio: return F("radio");
+      case ProfileAnimate: return F("animate");
+      case ProfileBlend: return F("blend");
+      case ProfileEffectsAnimate: return F("fx anim");
+      case ProfileEffectsDraw: return F("fx draw");
+      case ProfileShow: return F("show");
+      case ProfileDebug: return F("debug");
+      case ProfileQuantize: return F("quantize");
+    }
+    return F("?");
+  }
+
+  void print() {
+    Serial.println(F("stage: min avg max recent-max us | log2 histogram"));
+    for (uint8_t i = 0; i < PROFILE_STAGES; i++) {
+      StageProfile &s = this->stages[i];
+      Serial.print(this->stage_name(i));
+      Serial.print(F(": "));
+      if (!s.samples) {
+        Serial.println(F("-"));
+        continue;
+      }
+      Serial.print(s.min);
+      Serial.print(F(" "));
+      Serial.print(s.total / s.samples);
+      Serial.print(F(" "));
+      Serial.print(s.max);
+      Serial.print(F(" "));
+      Serial.print(s.recent_max());
+      Serial.print(F(" |"));
+      for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+        Serial.print(F(" "));
+        Serial.print(s.histogram[b]);
+      }
+      Serial.println();
+    }
+  }
+};
+
+#ifdef PROFILING
+Profiler profiler;
+
+#define PROFILE_START(name) uint32_t _profile_##name = micros()
+#define PROFILE_END(name, stage) profiler.record(stage, micros() - _profile_##name)
+#else
+#define PROFILE_START(name)
+#define PROFILE_END(name, stage)
+#endif
@@ -3,8 +3,24 @@
 
 #include <SPI.h>
 #include <NRFLite.h>
-
-#define RADIO_VERSION 1
+#include <stddef.h>
+#include "crc.h"
+#include "log.h"
+
+// Version 2 brought sequence numbers, the packed STATE and crc16.  Tubes
+// only hear tubes with the same version on the wire, on its own channel, so
+// a fleet is upgraded in two steps: first to firmware built with
+// RADIO_V1_COMPAT, which speaks version 1 (its channel, checksum and raw
+// UPDATE/NEXT commands) and still relays and dedupes among upgraded tubes;
+// then, once no version 1 tubes are left, to plain version 2.
+#define RADIO_VERSION 2
+// #define RADIO_V1_COMPAT                          // talk to version 1 tubes while a fleet is upgraded
+
+#ifdef RADIO_V1_COMPAT
+#define RADIO_WIRE_VERSION 1
+#else
+#define RADIO_WIRE_VERSION RADIO_VERSION
+#endif
 
 #ifdef USERADIO
 NRFLite _radio(Serial);
@@ -20,23 +36,213 @@ const static uint8_t PIN_RADIO_MISO = 12;           // hardware pins
 const static uint8_t PIN_RADIO_SCK = 13;            // hardware pins
 
 #define RADIO_BITRATE NRFLite::BITRATE1MBPS         // { BITRATE2MBPS, BITRATE1MBPS, BITRATE250KBPS }
-#define RADIO_CHANNEL 100 + RADIO_VERSION           // Channel hop with each version
+#define RADIO_CHANNEL 100 + RADIO_WIRE_VERSION      // Channel hop with each version
 #define RADIO_SENDPERIOD 1000                       // how often we broadcast, in millisec
+#define RADIO_IRQ_PIN 8                             // NRF24 IRQ; undefine to poll the radio instead
+#define RADIO_RING_SIZE 8                           // received packets waiting to be handled (power of 2)
+#define RADIO_RECEIVE_BUDGET_MICROS 1000            // most time for sending and handling packets per call
+#define RADIO_PACKET_MICROS 330                     // airtime of one packet at 1Mbps, with preamble, address & CRC
+#define RADIO_SEND_MICROS (RADIO_PACKET_MICROS + 300) // send() blocks for the airtime, TX & RX settling and the SPI load
+#define RADIO_TASK_BUDGET_MICROS (2 * RADIO_SEND_MICROS) // least the radio task needs: an update, and the send or packet that overruns
+
+#ifndef RADIO_HANDLED
+#define RADIO_HANDLED()                             // after each packet taken from the ring; the sim charges CPU here
+#endif
+
+#define RADIO_SEEN_SIZE 16                          // recently handled messages, to drop duplicates
+#define RADIO_OWN_SEQ_WINDOW 32                     // our last messages, which relays may still echo back
+#define RADIO_RELAY_SLOTS 4                         // messages waiting to be relayed
+#define RADIO_RELAY_MIN_DELAY 2                     // relays wait a random delay, in millisec...
+#define RADIO_RELAY_MAX_DELAY 30
+#ifndef RADIO_RELAY_COPIES
+#define RADIO_RELAY_COPIES 3                        // ...and are dropped if this many copies were heard by then
+#endif
+#define RADIO_HOP_MICROS 600                        // from send() to the receiver's interrupt
+
+// #define RADIO_HARDWARE_CRC                       // trust the CRC the NRF24 checks in hardware; skip the software one
+
+// #define RADIO_TDMA                               // send updates only in a beat-aligned slot, starting from tubeId's
+#define RADIO_TDMA_SLOTS 32                         // slots per two beats
+#define RADIO_TDMA_SLOT_FRACS (512 / RADIO_TDMA_SLOTS)
+#define RADIO_TDMA_GUARD_FRACS 2                    // at each end of a slot, for clock error between tubes
 
 class Radio;
 
 typedef uint16_t CommandId;
 typedef uint8_t TubeId;
 
-#define MESSAGE_DATA_MAX_SIZE 25
+#define MESSAGE_DATA_MAX_SIZE 24
 typedef struct {
   CommandId command;
   TubeId tubeId;
   TubeId relayId;
   byte data[MESSAGE_DATA_MAX_SIZE];
-  uint16_t crc = 0;
+  uint8_t seq;                                      // per originating tube
+  uint8_t age;                                      // millisec since the origin sent it, added up by relays
+  uint16_t crc = 0;                                 // of every byte before it
 } RadioMessage;
 
+#define MESSAGE_CRC_SIZE offsetof(RadioMessage, crc)
+static_assert(MESSAGE_CRC_SIZE == 30, "RadioMessage mustn't have padding before crc");
+// Version 1 had 25 data bytes, where version 2 has data and seq
+#define MESSAGE_V1_DATA_SIZE (offsetof(RadioMessage, seq) + 1 - offsetof(RadioMessage, data))
+
+// The tube that first sent a message; relays keep it in relayId
+TubeId messageOrigin(RadioMessage &message) {
+  return message.relayId ? message.relayId : message.tubeId;
+}
+
+typedef struct {
+  RadioMessage message;
+  uint32_t received_micros;
+} RadioPacket;
+
+// Received packets, written by the radio interrupt and read by the main loop.
+// Single producer, single consumer: each side only writes its own index.
+class RadioRing {
+  public:
+    RadioPacket packets[RADIO_RING_SIZE];
+    volatile uint8_t head = 0;
+    volatile uint8_t tail = 0;
+    volatile uint32_t dropped = 0;
+
+  // Producer: the slot to fill, or NULL if full
+  RadioPacket *claim() {
+    if ((uint8_t)(this->head - this->tail) == RADIO_RING_SIZE)
+      return NULL;
+    return &this->packets[this->head % RADIO_RING_SIZE];
+  }
+
+  void publish() {
+    __asm__ __volatile__("" ::: "memory");
+    this->head++;
+  }
+
+  // Consumer: the oldest packet, or NULL if empty
+  RadioPacket *peek() {
+    if (this->head == this->tail)
+      return NULL;
+    __asm__ __volatile__("" ::: "memory");
+    return &this->packets[this->tail % RADIO_RING_SIZE];
+  }
+
+  void pop() {
+    __asm__ __volatile__("" ::: "memory");
+    this->tail++;
+  }
+};
+
+#ifdef USERADIO
+RadioRing _radio_ring;
+
+// Moves one packet from the radio's FIFO into the ring
+void _radio_store() {
+  RadioPacket *packet = _radio_ring.claim();
+  if (!packet) {
+    RadioMessage discard;
+    _radio.readData(&discard);
+    _radio_ring.dropped++;
+    return;
+  }
+
+  _radio.readData(&packet->message);
+  packet->received_micros = micros();
+  _radio_ring.publish();
+}
+
+void _radio_isr() {
+  while (_radio.hasDataISR())
+    _radio_store();
+}
+#endif
+
+// Traffic seen by this tube, printed and restarted with the debug stats
+class RadioStats {
+  public:
+    uint32_t start_millis = 0;
+    uint32_t start_dropped = 0;
+    uint16_t sent = 0;
+    uint16_t send_failures = 0;
+    uint16_t received = 0;
+    uint16_t relayed = 0;
+    uint16_t suppressed = 0;
+    uint16_t duplicates = 0;
+    uint16_t corrupt = 0;
+    uint16_t ignored = 0;
+
+  void reset(uint32_t dropped) {
+    this->start_millis = millis();
+    this->start_dropped = dropped;
+    this->sent = this->send_failures = 0;
+    this->received = this->relayed = 0;
+    this->suppressed = this->duplicates = 0;
+    this->corrupt = this->ignored = 0;
+  }
+
+  void print(uint32_t dropped) {
+    uint32_t elapsed = millis() - this->start_millis;
+    uint32_t packets = this->sent + this->relayed + this->received;
+
+    Serial.print(F("Radio: "));
+    Serial.print(this->sent);
+    Serial.print(F(" sent ("));
+    Serial.print(this->send_failures);
+    Serial.print(F(" failed), "));
+    Serial.print(this->received);
+    Serial.print(F(" received, "));
+    Serial.print(this->relayed);
+    Serial.print(F(" relayed ("));
+    Serial.print(this->suppressed);
+    Serial.print(F(" suppressed), "));
+    Serial.print(this->duplicates);
+    Serial.print(F(" duplicates, "));
+    Serial.print(this->ignored);
+    Serial.print(F(" ignored, "));
+    Serial.print(this->corrupt);
+    Serial.print(F(" corrupt, "));
+    Serial.print(dropped - this->start_dropped);
+    Serial.print(F(" dropped; airtime "));
+    Serial.print(elapsed ? packets * RADIO_PACKET_MICROS / elapsed : 0);
+    Serial.println(F(" ms/s"));
+  }
+};
+
+// Ring of (origin, seq) of the messages handled most recently
+class SeenMessages {
+  public:
+    TubeId origin[RADIO_SEEN_SIZE];
+    uint8_t seq[RADIO_SEEN_SIZE];
+    uint8_t next = 0;
+
+  SeenMessages() {
+    memset(this->origin, 0, sizeof(this->origin));
+  }
+
+  bool contains(TubeId origin, uint8_t seq) {
+    for (uint8_t i = 0; i < RADIO_SEEN_SIZE; i++) {
+      if (this->origin[i] == origin && this->seq[i] == seq)
+        return true;
+    }
+    return false;
+  }
+
+  void add(TubeId origin, uint8_t seq) {
+    this->origin[this->next] = origin;
+    this->seq[this->next] = seq;
+    this->next = (this->next + 1) % RADIO_SEEN_SIZE;
+  }
+};
+
+// A message we may relay, once its delay is up, unless enough copies were heard
+class PendingRelay {
+  public:
+    RadioMessage message;
+    uint32_t received_micros = 0;
+    uint32_t due = 0;
+    uint8_t copies = 0;
+    bool active = false;
+};
+
 class MessageReceiver {
   public:
 
@@ -45,23 +251,35 @@ class MessageReceiver {
   }
 };
 
-uint16_t calculate_crc( byte *data, byte len ) {
-
-  const unsigned long crc_table[16] = {
-    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
-    0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
-    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
-    0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
-  };
+// Covers the header too: election, duplicates and clock sync depend on the
+// IDs, seq and age as much as the commands depend on the data.  Version 1
+// tubes always check their own checksum, over the data alone.
+uint16_t calculate_crc(RadioMessage &message) {
+#if defined(RADIO_V1_COMPAT)
+  return legacy_crc((const uint8_t *)&message + offsetof(RadioMessage, data), MESSAGE_V1_DATA_SIZE);
+#elif defined(RADIO_HARDWARE_CRC)
+  return 0;
+#else
+  return crc16((const uint8_t *)&message, MESSAGE_CRC_SIZE);
+#endif
+}
 
-  unsigned long crc = ~0L;
+bool check_crc(RadioMessage &message) {
+#if defined(RADIO_HARDWARE_CRC) && !defined(RADIO_V1_COMPAT)
+  return true;
+#else
+  return calculate_crc(message) == message.crc;
+#endif
+}
 
-  for ( unsigned int index = 0 ; index < len  ; ++index ) {
-    crc = crc_table[( crc ^ data[index] ) & 0x0f] ^ (crc >> 4);
-    crc = crc_table[( crc ^ ( data[index] >> 4 )) & 0x0f] ^ (crc >> 4);
-    crc = ~crc;
-  }
-  return crc & 65535;
+// Version 1 tubes leave seq 0 (and age uninitialized): their messages can't
+// be told from their copies
+bool isNumbered(RadioMessage &message) {
+#ifdef RADIO_V1_COMPAT
+  return message.seq != 0;
+#else
+  return true;
+#endif
 }
 
 uint8_t newTubeId() {
@@ -92,6 +310,16 @@ class Radio {
     unsigned long radioFailures = 0;
     unsigned long radioRestarts = 0;
 
+    uint32_t received_micros = 0;                  // when the packet being handled arrived
+    uint32_t master_millis = 0;                    // when masterTubeId last changed
+    BeatFrame_24_8 beat_frame = 0;                 // the shared beat clock, for TDMA slots
+    RadioStats stats;
+
+    uint8_t seq = 0;                               // of the next message we originate
+    uint8_t tdma_slot = 0;                         // see inSlot()
+    SeenMessages seen;
+    PendingRelay relays[RADIO_RELAY_SLOTS];
+
   void setup(bool isMaster) {
     if (isMaster)
       this->resetId(254);
@@ -104,27 +332,132 @@ class Radio {
     SPI.setMOSI(PIN_RADIO_MOSI);
     SPI.setMISO(PIN_RADIO_MISO);
 #endif
+    this->pause_rx();
     SPI.begin();
     
     this->reported_no_radio = false;
     if (_radio.init(RADIO_RX_ID, PIN_RADIO_CE, PIN_RADIO_CSN, RADIO_BITRATE, RADIO_CHANNEL)) {
       this->alive = true;
+#ifdef RADIO_IRQ_PIN
+      pinMode(RADIO_IRQ_PIN, INPUT);
+      SPI.usingInterrupt(digitalPinToInterrupt(RADIO_IRQ_PIN));
+      this->resume_rx();
+#endif
     }
     Serial.println(this->alive ? F("Radio: ok") : F("Radio: fail"));
+    this->stats.reset(this->dropped());
   
     // Start the radio, but mute & listen for a bit
 #endif
   }
 
+#ifdef USERADIO
+  void pause_rx() {
+#ifdef RADIO_IRQ_PIN
+    detachInterrupt(digitalPinToInterrupt(RADIO_IRQ_PIN));
+#endif
+  }
+
+  void resume_rx() {
+#ifdef RADIO_IRQ_PIN
+    attachInterrupt(digitalPinToInterrupt(RADIO_IRQ_PIN), _radio_isr, FALLING);
+#endif
+  }
+
+  // The interrupt handler and the main loop mustn't talk to the radio at once
+  bool transmit(RadioMessage &message) {
+    this->pause_rx();
+    bool sent = _radio.send(RADIO_TX_ID, &message, sizeof(message), NRFLite::NO_ACK);
+    // send() leaves the NRF24 in TX mode, deaf, until something switches it back
+    _radio.hasData(1);
+    this->resume_rx();
+    return sent;
+  }
+
+  void poll() {
+#ifdef RADIO_IRQ_PIN
+    // Catch packets that arrived while the interrupt was detached: the IRQ
+    // line stays low, so there won't be another falling edge
+    if (digitalRead(RADIO_IRQ_PIN) == LOW) {
+      this->pause_rx();
+      _radio_isr();
+      this->resume_rx();
+    }
+#else
+    while (_radio.hasData())
+      _radio_store();
+#endif
+  }
+#endif
+
+  uint8_t slot() {
+    return this->tdma_slot;
+  }
+
+  // With RADIO_TDMA, tubes take turns sending their updates, each in a slot
+  // of the two-beat cycle.  Slots start as tubeId % RADIO_TDMA_SLOTS, so two
+  // tubes can share one: a tube that hears another tube's own (unrelayed)
+  // message during its slot moves to another slot at random.
+  bool inSlot() {
+#ifdef RADIO_TDMA
+    uint16_t pos = (this->beat_frame % (RADIO_TDMA_SLOTS * RADIO_TDMA_SLOT_FRACS)) - this->slot() * RADIO_TDMA_SLOT_FRACS;
+    return pos >= RADIO_TDMA_GUARD_FRACS && pos < RADIO_TDMA_SLOT_FRACS - RADIO_TDMA_GUARD_FRACS;
+#else
+    return true;
+#endif
+  }
+
+  uint32_t dropped() {
+#ifdef USERADIO
+    return _radio_ring.dropped;
+#else
+    return 0;
+#endif
+  }
+
+  void printStats() {
+    this->stats.print(this->dropped());
+    this->stats.reset(this->dropped());
+
+    Serial.print(F("Master "));
+    Serial.print(this->masterTubeId);
+    Serial.print(F(" for "));
+    Serial.print((millis() - this->master_millis) / 1000);
+    Serial.println(F("s"));
+  }
+
+  void moveSlot(TubeId heard) {
+    this->tdma_slot = (this->tdma_slot + 1 + random8(RADIO_TDMA_SLOTS - 1)) % RADIO_TDMA_SLOTS;
+    LOG_INFO(LogSlotMoved, heard, this->tdma_slot, 0);
+  }
+
+  // One of the last RADIO_OWN_SEQ_WINDOW messages we originated
+  bool sentRecently(uint8_t seq) {
+    uint8_t back = this->seq - seq;
+    return back >= 1 && back <= RADIO_OWN_SEQ_WINDOW;
+  }
+
+  uint8_t nextSeq() {
+#ifdef RADIO_V1_COMPAT
+    // 0 is left to version 1 tubes
+    if (this->seq == 0)
+      this->seq++;
+#endif
+    return this->seq++;
+  }
+
   void resetId(uint8_t id=0) {
     if (id == 0)
       id = newTubeId();
     this->tubeId = id;
+    this->tdma_slot = id % RADIO_TDMA_SLOTS;
     Serial.print(F("My ID is "));
     Serial.println(this->tubeId);
 
-    if (this->tubeId > this->masterTubeId)
+    if (this->tubeId > this->masterTubeId) {
       this->masterTubeId = 0;
+      this->master_millis = millis();
+    }
   }
 
   bool sendCommand(uint32_t command, void *data=0, uint8_t size=0, TubeId relayId=0)
@@ -147,28 +480,32 @@ class Radio {
   
     message.tubeId = id;
     message.relayId = relayId;
-    message.command = command + (RADIO_VERSION << 12);
+    message.command = command + (RADIO_WIRE_VERSION << 12);
+    message.seq = this->nextSeq();
+    message.age = 0;
     memset(message.data, 0, sizeof(message.data));
     memcpy(message.data, data, size);
-    uint16_t crc = calculate_crc(message.data, sizeof(message.data));
-    message.crc = crc;
-
-    Serial.print(F("["));
-    Serial.print(message.tubeId);
-    Serial.print(F(": "));
-    Serial.print(message.command, HEX);
-  
-    sent = _radio.send(RADIO_TX_ID, &message, sizeof(message), NRFLite::NO_ACK);
-    Serial.print(sent ? F(" ok] ") : F(" failed] "));
+    message.crc = calculate_crc(message);
+    this->seen.add(id, message.seq);
+
+    sent = this->transmit(message);
+    this->stats.sent++;
+    if (!sent)
+      this->stats.send_failures++;
+    LOG_INFO(LogSent, message.tubeId, message.command, sent);
 #endif
 
     return sent;
   }
 
-  void receiveCommands(MessageReceiver *receiver)
+  // `start` is when the radio task started, so what it sent before counts
+  // against the budget.  The packet or relay that runs out the budget can
+  // overrun it by up to RADIO_SEND_MICROS.
+  void receiveCommands(MessageReceiver *receiver, uint32_t start=micros(), uint32_t budget=RADIO_RECEIVE_BUDGET_MICROS)
   {
 #ifdef USERADIO
     RadioMessage message;
+    RadioPacket *packet;
   
     if (!this->alive && !this->reported_no_radio)
     {
@@ -177,72 +514,159 @@ class Radio {
       return;
     }
     
-    // check for incoming data
-    while (_radio.hasData())
+    // Relays that are due go first, then received packets, until the budget
+    // runs out; the rest wait for the next call
+    this->sendRelays(start, budget);
+    this->poll();
+    while ((packet = _radio_ring.peek()) != NULL)
     {
-      _radio.readData(&message);
+      if (micros() - start > budget)
+        break;
+
+      message = packet->message;
+      bool numbered = isNumbered(message);
+      if (!numbered)
+        message.age = 0;
+      // As if it came straight from the origin, for clock sync
+      this->received_micros = packet->received_micros - message.age * 1000;
+      _radio_ring.pop();
+      RADIO_HANDLED();
+      this->stats.received++;
+      LOG_DEBUG(LogReceived, message.tubeId, message.command, (message.relayId << 8) | message.seq);
 
       // Messages must be from a tube with the current version
-      if ((message.command>>12) != RADIO_VERSION)
-        return;
-
-      // Ignore relayed messages if we already have a master
-      if (message.relayId && message.relayId <= this->masterTubeId)
-        return;
+      if ((message.command>>12) != RADIO_WIRE_VERSION) {
+        this->stats.ignored++;
+        LOG_DEBUG(LogIgnored, message.tubeId, LogWrongVersion, 0);
+        continue;
+      }
 
       // Filter out corrupt messages
-      unsigned long crc = calculate_crc(message.data, sizeof(message.data));
-      if (crc != message.crc) {
+      if (!check_crc(message)) {
         // Corrupt packet... ignore it.
-        Serial.print(F("Invalid CRC: "));
-        Serial.print(message.crc);
-        Serial.print(F(" should be "));
-        Serial.println(crc);
+        LOG_ERROR(LogCorrupt, message.tubeId, message.crc, calculate_crc(message));
+        this->stats.corrupt++;
+        continue;
+      }
+
+#ifdef RADIO_TDMA
+      // Someone else sends in our slot; only matters while we lead, since
+      // followers don't send
+      if (!message.relayId && !this->masterTubeId && this->inSlot())
+        this->moveSlot(message.tubeId);
+#endif
+
+      // Already handled (or our own, relayed back): just count the copy, to
+      // decide whether to relay it
+      TubeId origin = messageOrigin(message);
+      if (numbered && this->seen.contains(origin, message.seq)) {
+        this->heardCopy(message);
+        continue;
+      }
+
+      // Ignore relayed messages from below our master
+      if (message.relayId && message.relayId < this->masterTubeId) {
+        this->stats.ignored++;
+        LOG_DEBUG(LogIgnored, message.tubeId, LogRelayedFromMaster, 0);
+        continue;
+      }
+
+      // A relay echoing one of our own messages, after it left the seen cache
+      if (numbered && origin == this->tubeId && message.tubeId != this->tubeId && this->sentRecently(message.seq)) {
+        this->heardCopy(message);
         continue;
       }
 
       // If we detect an ID collision, fix it by choosing a new random one
-      while (message.tubeId == this->tubeId) {
-        Serial.print(F("ID collision!"));
+      while (message.tubeId == this->tubeId || origin == this->tubeId) {
+        Serial.println(F("ID collision!"));
         this->resetId();
       }
 
-      // Ignore messages from a lower ID
-      if (message.tubeId < this->tubeId) {
-        // Don't need to be noisy about relayed messages
-        if (message.relayId == 0) {
-          Serial.print(F("Ignoring message from "));
-          Serial.println(message.tubeId);
-        }
-        return;
+      // Elect and obey by the origin, so relays carry the master's updates
+      // past tubes with lower IDs than the relay's
+      if (origin < this->tubeId) {
+        this->stats.ignored++;
+        LOG_DEBUG(LogIgnored, origin, LogLowerId, 0);
+        continue;
       }
 
-      if (message.tubeId != 255 && message.tubeId > this->masterTubeId) {
+      if (origin != 255 && origin > this->masterTubeId) {
         // Found a new master!
-        this->masterTubeId = message.tubeId;
+        this->masterTubeId = origin;
+        this->master_millis = millis();
         Serial.print(F("All hail new master "));
         Serial.println(this->masterTubeId);
       }  
 
-      // Process the command
-      receiver->onCommand(message.tubeId, message.command & 0xFFF, message.data);
-
-      // Occcasionally relay commands - more frequently if higher ID
-      uint8_t r = random8();
-      if ((r % 3 == 0) && r < this->tubeId) {
-        Serial.print(F(" (relaying as "));
-        Serial.print(this->tubeId);
-        Serial.print(F(")"));
-        message.relayId = message.tubeId;
-        message.tubeId = this->tubeId;
-        _radio.send(RADIO_TX_ID, &message, sizeof(message), NRFLite::NO_ACK);
-      }
-      
-      Serial.println();
+      // Process the command; version 1 tubes relay their own
+      if (numbered)
+        this->seen.add(origin, message.seq);
+      receiver->onCommand(origin, message.command & 0xFFF, message.data);
+      if (numbered)
+        this->scheduleRelay(message);
     }
 #endif
   }
 
+#ifdef USERADIO
+  // Counter-based relaying: every tube that handles a message waits a random
+  // delay, and relays it only if it didn't hear enough copies in the meantime.
+  // Dense clusters send a relay or two; sparse chains still pass it along.
+  void scheduleRelay(RadioMessage &message) {
+    for (uint8_t i = 0; i < RADIO_RELAY_SLOTS; i++) {
+      PendingRelay &relay = this->relays[i];
+      if (relay.active)
+        continue;
+
+      relay.message = message;
+      relay.received_micros = this->received_micros;
+      relay.due = millis() + random8(RADIO_RELAY_MIN_DELAY, RADIO_RELAY_MAX_DELAY);
+      relay.copies = 1;
+      relay.active = true;
+      return;
+    }
+    this->stats.suppressed++;
+  }
+
+  void heardCopy(RadioMessage &message) {
+    this->stats.duplicates++;
+    TubeId origin = messageOrigin(message);
+    LOG_DEBUG(LogDuplicate, origin, message.seq, 0);
+    for (uint8_t i = 0; i < RADIO_RELAY_SLOTS; i++) {
+      PendingRelay &relay = this->relays[i];
+      if (relay.active && messageOrigin(relay.message) == origin && relay.message.seq == message.seq)
+        relay.copies++;
+    }
+  }
+
+  void sendRelays(uint32_t start, uint32_t budget) {
+    for (uint8_t i = 0; i < RADIO_RELAY_SLOTS; i++) {
+      PendingRelay &relay = this->relays[i];
+      if (!relay.active || (int32_t)(millis() - relay.due) < 0)
+        continue;
+      if (micros() - start > budget)
+        return;
+      relay.active = false;
+
+      if (relay.copies >= RADIO_RELAY_COPIES) {
+        this->stats.suppressed++;
+        continue;
+      }
+
+      RadioMessage &message = relay.message;
+      message.relayId = messageOrigin(message);
+      message.tubeId = this->tubeId;
+      uint32_t age = (micros() - relay.received_micros + RADIO_HOP_MICROS + 500) / 1000;
+      message.age = min(age, 255U);
+      message.crc = calculate_crc(message);
+      LOG_INFO(LogRelayed, message.relayId, message.seq, 0);
+      this->transmit(message);
+      this->stats.relayed++;
+    }
+  }
+#endif
+
 };
 
 #endif
@@ -0,0 +1,141 @@
+#pragma once
+
+// Cooperative deadline scheduler for the main loop.  Each task is released
+// every period; the most urgent released task runs first.  A task only starts
+// if its budget fits before the next release of every more urgent task, so
+// slow background work (LCD, radio, serial) can't push back the next frame.
+// A task that has waited past its deadline runs anyway, and counts a miss.
+// A task that can do more or less work reads `slack` to size it.
+
+#define SCHEDULER_MAX_TASKS 10
+
+typedef void (*TaskFn)();
+
+class Task {
+  public:
+    const __FlashStringHelper *name;
+    TaskFn fn;
+    uint32_t period;     // micros between releases
+    uint32_t deadline;   // micros after release by which it should have started
+    uint32_t budget;     // expected worst-case runtime, in micros
+    uint8_t priority;    // lower runs first
+    uint32_t release;    // micros of the next release
+
+    uint32_t runs;
+    uint32_t misses;
+    uint32_t max_late;
+    uint32_t max_runtime;
+
+  void reset_stats() {
+    this->runs = 0;
+    this->misses = 0;
+    this->max_late = 0;
+    this->max_runtime = 0;
+  }
+};
+
+class Scheduler {
+  public:
+    Task tasks[SCHEDULER_MAX_TASKS];
+    uint8_t num_tasks = 0;
+    uint32_t idle = 0;
+    uint32_t slack = 0;  // while a task runs: micros until a more urgent task is released
+
+  void add(const __FlashStringHelper *name, TaskFn fn, uint32_t period, uint8_t priority, uint32_t budget, uint32_t deadline=0) {
+    if (this->num_tasks == SCHEDULER_MAX_TASKS) {
+      Serial.println(F("Too many tasks"));
+      return;
+    }
+
+    Task &task = this->tasks[this->num_tasks++];
+    task.name = name;
+    task.fn = fn;
+    task.period = period;
+    task.deadline = deadline ? deadline : period;
+    task.budget = budget;
+    task.priority = priority;
+    task.release = micros();
+    task.reset_stats();
+  }
+
+  // Run at most one task.  Call from loop().
+  void run() {
+    uint32_t now = micros();
+
+    int8_t next = -1;
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+      Task &task = this->tasks[i];
+      if ((int32_t)(now - task.release) < 0)
+        continue;
+      if (next < 0 || task.priority < this->tasks[next].priority)
+        next = i;
+    }
+    if (next < 0) {
+      this->idle++;
+      return;
+    }
+
+    Task &task = this->tasks[next];
+    uint32_t late = now - task.release;
+    this->slack = this->slack_for(task, now);
+    if (late <= task.deadline && this->slack < task.budget) {
+      this->idle++;
+      return;
+    }
+
+    task.fn();
+    uint32_t runtime = micros() - now;
+
+    task.runs++;
+    if (late > task.deadline)
+      task.misses++;
+    if (late > task.max_late)
+      task.max_late = late;
+    if (runtime > task.max_runtime)
+      task.max_runtime = runtime;
+
+    // Keep the phase unless a whole period was lost
+    task.release += task.period;
+    if ((int32_t)(now - task.release) >= 0)
+      task.release = now + task.period;
+  }
+
+  uint32_t slack_for(Task &task, uint32_t now) {
+    int32_t slack = INT32_MAX;
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+      Task &other = this->tasks[i];
+      if (other.priority >= task.priority)
+        continue;
+      int32_t until = other.release - now;
+      if (until < slack)
+        slack = until;
+    }
+    return max(slack, 0);
+  }
+
+  void print() {
+    Serial.println(F("task: runs misses max-late max-runtime us"));
+    for (uint8_t i = 0; i < this->num_tasks; i++) {
+      Task &task = this->tasks[i];
+      Serial.print(task.name);
+      Serial.print(F(": "));
+      Serial.print(task.runs);
+      Serial.print(F(" "));
+      Serial.print(task.misses);
+      Serial.print(F(" "));
+      Serial.print(task.max_late);
+      Serial.print(F(" "));
+      Serial.println(task.max_runtime);
+    }
+    Serial.print(F("idle: "));
+    Serial.println(this->idle);
+  }
+
+  void reset() {
+    for (uint8_t i = 0; i < this->num_tasks; i++)
+      this->tasks[i].reset_stats();
+    this->idle = 0;
+  }
+};
+
+Scheduler scheduler;
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for Adafruit GFX; the display stand-in draws its own text.
+
+#include "Arduino.h"
@@ -0,0 +1,52 @@
+#pragma once
+
+// Host stand-in for Adafruit_SSD1306 on I2C.  Text goes into the RAM buffer
+// as a made-up but deterministic 6x8 glyph per character, so changing text
+// changes the same pixels the real font would; display() sends the whole
+// buffer over the Wire stand-in, as the library does.
+
+#include "Arduino.h"
+#include "Wire.h"
+#include "Adafruit_GFX.h"
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_EXTERNALVCC 0x01
+
+#define BLACK 0
+#define WHITE 1
+#define INVERSE 2
+
+class Adafruit_SSD1306 : public Print {
+  public:
+    int16_t w;
+    int16_t h;
+    TwoWire *wire;
+    uint8_t address = 0;
+    uint8_t *buffer = NULL;
+    int16_t cursor_x = 0;
+    int16_t cursor_y = 0;
+    uint8_t text_size = 1;
+    uint16_t text_color = WHITE;
+    uint16_t text_bg = WHITE;   // same as the color: transparent
+
+  Adafruit_SSD1306(uint8_t w, uint8_t h, TwoWire *twi=&Wire, int8_t rst_pin=-1) : w(w), h(h), wire(twi) {}
+  ~Adafruit_SSD1306() { free(this->buffer); }
+
+  bool begin(uint8_t switchvcc=SSD1306_SWITCHCAPVCC, uint8_t i2caddr=0, bool reset=true, bool periphBegin=true);
+  void display();
+  void clearDisplay();
+  void ssd1306_command(uint8_t c);
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  uint8_t *getBuffer() { return this->buffer; }
+
+  void setCursor(int16_t x, int16_t y) { this->cursor_x = x; this->cursor_y = y; }
+  void setTextSize(uint8_t s) { this->text_size = s > 0 ? s : 1; }
+  void setTextColor(uint16_t c) { this->text_color = this->text_bg = c; }
+  void setTextColor(uint16_t c, uint16_t bg) { this->text_color = c; this->text_bg = bg; }
+  void cp437(bool x=true) {}
+  int16_t width() { return this->w; }
+  int16_t height() { return this->h; }
+
+  size_t write(uint8_t c);
+  using Print::write;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+// Host stand-in for the Teensy Arduino core.  Time is simulated: micros()
+// only moves when the harness advances the clock or a stand-in charges it
+// for hardware work (a send, an I2C transfer, showing a frame), so a run is
+// the same every time for the same seed.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+
+#include "host.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// The Teensy 3.x/4.x cycle counter, read from the host's
+#define ARM_DEMCR host.arm_demcr
+#define ARM_DEMCR_TRCENA (1 << 24)
+#define ARM_DWT_CTRL host.arm_dwt_ctrl
+#define ARM_DWT_CTRL_CYCCNTENA (1 << 0)
+#define ARM_DWT_CYCCNT host_cycles()
+
+class Print {
+  public:
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return this->write((const uint8_t *)str, strlen(str)); }
+
+  size_t print(const __FlashStringHelper *s) { return this->write((const char *)s); }
+  size_t print(const char s[]) { return this->write(s); }
+  size_t print(char c) { return this->write((uint8_t)c); }
+  size_t print(unsigned char n, int base=DEC) { return this->print((unsigned long)n, base); }
+  size_t print(int n, int base=DEC) { return this->print((long)n, base); }
+  size_t print(unsigned int n, int base=DEC) { return this->print((unsigned long)n, base); }
+  size_t print(long n, int base=DEC);
+  size_t print(unsigned long n, int base=DEC);
+  size_t print(double n, int digits=2);
+
+  size_t println() { return this->write((const uint8_t *)"\r\n", 2); }
+  template<class T> size_t println(T value) { size_t n = this->print(value); return n + this->println(); }
+  template<class T> size_t println(T value, int format) { size_t n = this->print(value, format); return n + this->println(); }
+};
+
+class Stream : public Print {
+  public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+// Output goes to host.serial_out; input is what the harness queued with
+// host_serial_input()
+class HostSerial : public Stream {
+  public:
+  void begin(long baud) {}
+  operator bool() { return true; }
+  int available();
+  int read();
+  int availableForWrite() { return 64; }
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
+};
+
+extern HostSerial Serial;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+void digitalWrite(uint8_t pin, uint8_t value);
+int analogRead(uint8_t pin);
+
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t irq, void (*isr)(), int mode);
+void detachInterrupt(uint8_t irq);
+void noInterrupts();
+void interrupts();
+
+void randomSeed(unsigned long seed);
+long random();
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+char *ltoa(long value, char *buffer, int radix);
+char *itoa(int value, char *buffer, int radix);
+char *ultoa(unsigned long value, char *buffer, int radix);
+
+int freeMemory();
+
+template<class A, class B> auto min(A a, B b) -> typename std::decay<decltype(a < b ? a : b)>::type { return a < b ? a : b; }
+template<class A, class B> auto max(A a, B b) -> typename std::decay<decltype(a < b ? a : b)>::type { return a > b ? a : b; }
+template<class T> T constrain(T x, T lo, T hi) { return x < lo ? lo : (x > hi ? hi : x); }
@@ -0,0 +1,374 @@
+#pragma once
+
+// Host stand-in for the parts of FastLED the tubes use.  The 8-bit math
+// follows lib8tion's C fallbacks (with FASTLED_SCALE8_FIXED), so patterns
+// render the same values they do on the strips.  show() writes the frame to
+// host.frames instead of a data pin, and power limiting isn't modelled.
+
+#include "Arduino.h"
+
+#define FASTLED_VERSION 3003002
+#define FASTLED_SCALE8_FIXED 1
+#define FASTLED_USING_NAMESPACE
+
+typedef uint8_t fract8;
+typedef uint16_t fract16;
+typedef uint16_t accum88;
+typedef int16_t saccum78;
+
+// lib8tion math
+
+inline uint8_t scale8(uint8_t i, fract8 scale) {
+  return ((uint16_t)i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline uint8_t scale8_video(uint8_t i, fract8 scale) {
+  return (((uint16_t)i * (uint16_t)scale) >> 8) + ((i && scale) ? 1 : 0);
+}
+
+inline uint16_t scale16(uint16_t i, fract16 scale) {
+  return ((uint32_t)i * (1 + (uint32_t)scale)) >> 16;
+}
+
+inline uint16_t scale16by8(uint16_t i, fract8 scale) {
+  return (i * (1 + (uint16_t)scale)) >> 8;
+}
+
+inline void nscale8x3(uint8_t &r, uint8_t &g, uint8_t &b, fract8 scale) {
+  r = scale8(r, scale);
+  g = scale8(g, scale);
+  b = scale8(b, scale);
+}
+
+inline uint8_t qadd8(uint8_t i, uint8_t j) {
+  unsigned int t = i + j;
+  return t > 255 ? 255 : t;
+}
+
+inline uint8_t qsub8(uint8_t i, uint8_t j) {
+  int t = i - j;
+  return t < 0 ? 0 : t;
+}
+
+inline int8_t avg7(int8_t i, int8_t j) {
+  return (i >> 1) + (j >> 1) + (i & 0x1);
+}
+
+inline uint8_t lerp8by8(uint8_t a, uint8_t b, fract8 frac) {
+  if (b > a)
+    return a + scale8(b - a, frac);
+  return a - scale8(a - b, frac);
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB) {
+  uint16_t partial = (a << 8) | b;
+  partial += b * amountOfB;
+  partial -= a * amountOfB;
+  return partial >> 8;
+}
+
+inline uint8_t ease8InOutQuad(uint8_t i) {
+  uint8_t j = i;
+  if (j & 0x80)
+    j = 255 - j;
+  uint8_t jj2 = scale8(j, j) << 1;
+  if (i & 0x80)
+    jj2 = 255 - jj2;
+  return jj2;
+}
+
+inline uint8_t ease8InOutApprox(uint8_t i) {
+  if (i < 64) {
+    i /= 2;
+  } else if (i > 255 - 64) {
+    i = 255 - i;
+    i /= 2;
+    i = 255 - i;
+  } else {
+    i -= 64;
+    i += i / 2;
+    i += 32;
+  }
+  return i;
+}
+
+inline uint8_t triwave8(uint8_t in) {
+  if (in & 0x80)
+    in = 255 - in;
+  return in << 1;
+}
+
+int16_t sin16(uint16_t theta);
+uint8_t sin8(uint8_t theta);
+inline int16_t cos16(uint16_t theta) { return sin16(theta + 16384); }
+inline uint8_t cos8(uint8_t theta) { return sin8(theta + 64); }
+
+inline uint16_t beat88(accum88 beats_per_minute_88, uint32_t timebase=0) {
+  return ((millis() - timebase) * beats_per_minute_88 * 280) >> 16;
+}
+
+inline uint16_t beat16(accum88 beats_per_minute, uint32_t timebase=0) {
+  if (beats_per_minute < 256)
+    beats_per_minute <<= 8;
+  return beat88(beats_per_minute, timebase);
+}
+
+inline uint8_t beat8(accum88 beats_per_minute, uint32_t timebase=0) {
+  return beat16(beats_per_minute, timebase) >> 8;
+}
+
+inline uint16_t beatsin16(accum88 beats_per_minute, uint16_t lowest=0, uint16_t highest=65535, uint32_t timebase=0, uint16_t phase_offset=0) {
+  uint16_t beatsin = sin16(beat16(beats_per_minute, timebase) + phase_offset) + 32768;
+  return lowest + scale16(beatsin, highest - lowest);
+}
+
+inline uint8_t beatsin8(accum88 beats_per_minute, uint8_t lowest=0, uint8_t highest=255, uint32_t timebase=0, uint8_t phase_offset=0) {
+  uint8_t beatsin = sin8(beat8(beats_per_minute, timebase) + phase_offset);
+  return lowest + scale8(beatsin, highest - lowest);
+}
+
+// lib8tion random
+
+extern uint16_t rand16seed;
+
+inline uint16_t random16() {
+  rand16seed = (rand16seed * 2053) + 13849;
+  return rand16seed;
+}
+
+inline uint8_t random8() {
+  random16();
+  return (uint8_t)(rand16seed & 0xFF) + (uint8_t)(rand16seed >> 8);
+}
+
+inline uint8_t random8(uint8_t lim) {
+  return (random8() * lim) >> 8;
+}
+
+inline uint8_t random8(uint8_t min, uint8_t lim) {
+  return random8(lim - min) + min;
+}
+
+inline uint16_t random16(uint16_t lim) {
+  return ((uint32_t)random16() * lim) >> 16;
+}
+
+inline uint16_t random16(uint16_t min, uint16_t lim) {
+  return random16(lim - min) + min;
+}
+
+inline void random16_set_seed(uint16_t seed) {
+  rand16seed = seed;
+}
+
+inline void random16_add_entropy(uint16_t entropy) {
+  rand16seed += entropy;
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y);
+
+// Colors
+
+struct CHSV {
+  union {
+    struct {
+      union { uint8_t hue; uint8_t h; };
+      union { uint8_t saturation; uint8_t sat; uint8_t s; };
+      union { uint8_t value; uint8_t val; uint8_t v; };
+    };
+    uint8_t raw[3];
+  };
+
+  CHSV() {}
+  CHSV(uint8_t ih, uint8_t is, uint8_t iv) : hue(ih), sat(is), val(iv) {}
+};
+
+struct CRGB;
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb);
+
+struct CRGB {
+  union {
+    struct {
+      union { uint8_t r; uint8_t red; };
+      union { uint8_t g; uint8_t green; };
+      union { uint8_t b; uint8_t blue; };
+    };
+    uint8_t raw[3];
+  };
+
+  typedef enum {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Green = 0x008000,
+    Orange = 0xFFA500,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00,
+  } HTMLColorCode;
+
+  CRGB() {}
+  CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+  CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+  CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+  CRGB(const CHSV &rhs) { hsv2rgb_rainbow(rhs, *this); }
+
+  CRGB &operator=(const CHSV &rhs) { hsv2rgb_rainbow(rhs, *this); return *this; }
+  CRGB &operator=(uint32_t colorcode) { *this = CRGB(colorcode); return *this; }
+
+  uint8_t &operator[](uint8_t x) { return this->raw[x]; }
+  const uint8_t &operator[](uint8_t x) const { return this->raw[x]; }
+
+  CRGB &operator+=(const CRGB &rhs) {
+    this->r = qadd8(this->r, rhs.r);
+    this->g = qadd8(this->g, rhs.g);
+    this->b = qadd8(this->b, rhs.b);
+    return *this;
+  }
+
+  CRGB &operator-=(const CRGB &rhs) {
+    this->r = qsub8(this->r, rhs.r);
+    this->g = qsub8(this->g, rhs.g);
+    this->b = qsub8(this->b, rhs.b);
+    return *this;
+  }
+
+  // Brighter of each channel
+  CRGB &operator|=(const CRGB &rhs) {
+    if (rhs.r > this->r) this->r = rhs.r;
+    if (rhs.g > this->g) this->g = rhs.g;
+    if (rhs.b > this->b) this->b = rhs.b;
+    return *this;
+  }
+
+  // Dimmer of each channel
+  CRGB &operator&=(const CRGB &rhs) {
+    if (rhs.r < this->r) this->r = rhs.r;
+    if (rhs.g < this->g) this->g = rhs.g;
+    if (rhs.b < this->b) this->b = rhs.b;
+    return *this;
+  }
+
+  CRGB &nscale8(uint8_t scale) {
+    nscale8x3(this->r, this->g, this->b, scale);
+    return *this;
+  }
+
+  CRGB &fadeToBlackBy(uint8_t fade) {
+    return this->nscale8(255 - fade);
+  }
+
+  CRGB operator-() const {
+    return CRGB(255 - this->r, 255 - this->g, 255 - this->b);
+  }
+
+  explicit operator bool() const {
+    return this->r || this->g || this->b;
+  }
+
+  uint8_t getAverageLight() const {
+    return scale8(this->r, 85) + scale8(this->g, 85) + scale8(this->b, 85);
+  }
+};
+
+inline bool operator==(const CRGB &a, const CRGB &b) {
+  return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+inline bool operator!=(const CRGB &a, const CRGB &b) {
+  return !(a == b);
+}
+
+inline CRGB operator+(const CRGB &a, const CRGB &b) {
+  return CRGB(qadd8(a.r, b.r), qadd8(a.g, b.g), qadd8(a.b, b.b));
+}
+
+CRGB &nblend(CRGB &existing, const CRGB &overlay, fract8 amountOfOverlay);
+void fill_solid(CRGB *leds, int num_leds, const CRGB &color);
+void fill_rainbow(CRGB *leds, int num_leds, uint8_t initialhue, uint8_t deltahue=5);
+void nscale8(CRGB *leds, uint16_t num_leds, uint8_t scale);
+void fadeToBlackBy(CRGB *leds, uint16_t num_leds, uint8_t fadeBy);
+
+// Palettes
+
+typedef const uint8_t TProgmemRGBGradientPalette_byte;
+typedef const TProgmemRGBGradientPalette_byte *TProgmemRGBGradientPalette_bytes;
+typedef TProgmemRGBGradientPalette_bytes TProgmemRGBGradientPalettePtr;
+typedef const uint32_t TProgmemRGBPalette16[16];
+
+#define DEFINE_GRADIENT_PALETTE(X) \
+  extern const TProgmemRGBGradientPalette_byte X[] PROGMEM; \
+  const TProgmemRGBGradientPalette_byte X[] PROGMEM =
+
+extern const TProgmemRGBPalette16 PartyColors_p;
+extern const TProgmemRGBPalette16 RainbowColors_p;
+
+typedef enum { NOBLEND=0, LINEARBLEND=1 } TBlendType;
+
+class CRGBPalette16 {
+  public:
+    CRGB entries[16];
+
+  CRGBPalette16() {}
+  CRGBPalette16(const TProgmemRGBPalette16 &rhs) { *this = rhs; }
+  CRGBPalette16(TProgmemRGBGradientPalette_bytes progpal) { *this = progpal; }
+
+  CRGBPalette16 &operator=(const TProgmemRGBPalette16 &rhs);
+  CRGBPalette16 &operator=(TProgmemRGBGradientPalette_bytes progpal);
+
+  CRGB &operator[](uint8_t x) { return this->entries[x]; }
+  const CRGB &operator[](uint8_t x) const { return this->entries[x]; }
+};
+
+CRGB ColorFromPalette(const CRGBPalette16 &pal, uint8_t index, uint8_t brightness=255, TBlendType blendType=LINEARBLEND);
+
+// Controllers
+
+enum EOrder { RGB=0012, RBG=0021, GRB=0102, GBR=0120, BRG=0201, BGR=0210 };
+enum ESPIChipsets { NEOPIXEL, WS2812SERIAL };
+enum LEDColorCorrection { TypicalLEDStrip=0xFFB0F0, UncorrectedColor=0xFFFFFF };
+
+class CLEDController {
+  public:
+  CLEDController &setCorrection(uint32_t correction) { return *this; }
+  CLEDController &setCorrection(LEDColorCorrection correction) { return *this; }
+};
+
+class CFastLED {
+  public:
+    CLEDController controller;
+
+  template<ESPIChipsets CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER=RGB>
+  CLEDController &addLeds(CRGB *leds, int num_leds) {
+    host.leds = leds;
+    host.num_leds = num_leds;
+    return this->controller;
+  }
+
+  void show();
+  void setMaxPowerInMilliWatts(uint32_t milliwatts) { host.max_power_mw = milliwatts; }
+  void setBrightness(uint8_t scale) {}
+  void setDither(uint8_t dither) {}
+};
+
+extern CFastLED FastLED;
+
+class CEveryNMillis {
+  public:
+    uint32_t period;
+    uint32_t prev;
+
+  CEveryNMillis(uint32_t period) : period(period), prev(millis()) {}
+
+  bool ready() {
+    uint32_t now = millis();
+    if (now - this->prev < this->period)
+      return false;
+    this->prev = now;
+    return true;
+  }
+};
+
+#define EVERY_N_CONCAT2(a, b) a##b
+#define EVERY_N_CONCAT(a, b) EVERY_N_CONCAT2(a, b)
+#define EVERY_N_MILLISECONDS(N) static CEveryNMillis EVERY_N_CONCAT(every_n_, __LINE__)(N); if (EVERY_N_CONCAT(every_n_, __LINE__).ready())
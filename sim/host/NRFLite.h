@@ -0,0 +1,26 @@
+#pragma once
+
+// Host stand-in for NRFLite, over the simulated NRF24 in host.radio.  Like
+// the real radio, it only receives in RX mode: send() switches to TX and
+// stays there until hasData() (or startRx()) switches back.  hasDataISR()
+// never changes mode.  Packets go to the harness with host_radio_take().
+
+#include "Arduino.h"
+
+class NRFLite {
+  public:
+    enum Bitrates { BITRATE2MBPS, BITRATE1MBPS, BITRATE250KBPS };
+    enum SendType { REQUIRE_ACK, NO_ACK };
+
+  NRFLite(Stream &serial) {}
+  NRFLite() {}
+
+  uint8_t init(uint8_t radioId, uint8_t cePin, uint8_t csnPin, Bitrates bitrate=BITRATE2MBPS, uint8_t channel=100, uint8_t callSetup=1);
+  uint8_t send(uint8_t toRadioId, void *data, uint8_t length, SendType sendType=REQUIRE_ACK);
+  uint8_t hasData(uint8_t usingInterrupts=0);
+  uint8_t hasDataISR();
+  void readData(void *data);
+  void startRx();
+  void whatHappened(uint8_t &txOk, uint8_t &txFail, uint8_t &rxReady);
+  void powerDown() {}
+};
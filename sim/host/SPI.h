@@ -0,0 +1,17 @@
+#pragma once
+
+// Host stand-in for the SPI library: the radio stand-in charges its own
+// transfers, so there is nothing to do here.
+
+#include "Arduino.h"
+
+class SPIClass {
+  public:
+  void begin() {}
+  void setSCK(uint8_t pin) {}
+  void setMOSI(uint8_t pin) {}
+  void setMISO(uint8_t pin) {}
+  void usingInterrupt(uint8_t irq) {}
+};
+
+extern SPIClass SPI;
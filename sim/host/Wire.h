@@ -0,0 +1,23 @@
+#pragma once
+
+// Host stand-in for the Wire (I2C) library.  endTransmission() charges the
+// clock for the address and every byte, 9 bits each at the bus clock.
+
+#include "Arduino.h"
+
+#define WIRE_BUFFER_SIZE 32
+
+class TwoWire {
+  public:
+    uint8_t buffer[WIRE_BUFFER_SIZE];
+    uint8_t length = 0;
+    bool transmitting = false;
+
+  void begin() {}
+  void setClock(uint32_t frequency) { host.i2c_clock = frequency; }
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  uint8_t endTransmission(bool stop=true);
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,233 @@
+// Host stand-in for the Arduino core: the simulated clock, pins, interrupts,
+// Serial and random()
+
+#include "Arduino.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+Host host;
+HostSerial Serial;
+
+static uint32_t random_state = 1;
+
+void host_reset(uint32_t seed) {
+  memset(&host, 0, sizeof(host));
+  host.seed = seed;
+  memset(host.pins, HIGH, sizeof(host.pins));
+  for (int i = 0; i < HOST_PINS; i++)
+    host.analog[i] = 512;
+  host.serial_out = stdout;
+
+  host.show_micros = 1000;
+  host.i2c_clock = 100000;
+  host.lcd_present = true;
+
+  host.radio.present = true;
+  host.radio.settle_micros = 130;
+  host.radio.airtime_micros = 330;
+  host.radio.spi_micros = 40;
+  host.radio.handle_micros = 150;
+
+  random_state = 1;
+}
+
+void host_charge(uint32_t micros) {
+  host.clock += micros;
+}
+
+uint32_t host_seed() {
+  return host.seed;
+}
+
+uint32_t host_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return (uint32_t)__rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#endif
+}
+
+// Time
+
+uint32_t millis() {
+  return host.clock / 1000;
+}
+
+uint32_t micros() {
+  return (uint32_t)host.clock;
+}
+
+void delay(uint32_t ms) {
+  host_charge(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+  host_charge(us);
+}
+
+void yield() {
+}
+
+// Pins
+
+void pinMode(uint8_t pin, uint8_t mode) {
+}
+
+int digitalRead(uint8_t pin) {
+  // The NRF24's IRQ is active low while a received packet waits
+  if (host.radio_irq_pin && pin == host.radio_irq_pin)
+    return host.radio.fifo_count ? LOW : HIGH;
+  return pin < HOST_PINS ? host.pins[pin] : LOW;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin < HOST_PINS)
+    host.pins[pin] = value;
+}
+
+int analogRead(uint8_t pin) {
+  return pin < HOST_PINS ? host.analog[pin] : 0;
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(uint8_t irq, void (*isr)(), int mode) {
+  if (irq < HOST_PINS)
+    host.isr[irq] = isr;
+}
+
+void detachInterrupt(uint8_t irq) {
+  if (irq < HOST_PINS)
+    host.isr[irq] = NULL;
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+}
+
+// Random
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0)
+    random_state = seed;
+}
+
+long random() {
+  random_state = random_state * 1103515245 + 12345;
+  return (random_state >> 1) & 0x7FFFFFFF;
+}
+
+long random(long howbig) {
+  if (howbig == 0)
+    return 0;
+  return random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig)
+    return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+// Strings
+
+char *ultoa(unsigned long value, char *buffer, int radix) {
+  char digits[33];
+  int i = 0;
+  do {
+    uint8_t digit = value % radix;
+    digits[i++] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= radix;
+  } while (value);
+
+  char *p = buffer;
+  while (i)
+    *p++ = digits[--i];
+  *p = 0;
+  return buffer;
+}
+
+char *ltoa(long value, char *buffer, int radix) {
+  if (value < 0 && radix == 10) {
+    buffer[0] = '-';
+    ultoa(-(unsigned long)value, buffer + 1, radix);
+    return buffer;
+  }
+  return ultoa(value, buffer, radix);
+}
+
+char *itoa(int value, char *buffer, int radix) {
+  return ltoa(value, buffer, radix);
+}
+
+int freeMemory() {
+  return 0;
+}
+
+// Print and Serial
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--)
+    n += this->write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 10 && n < 0)
+    return this->print('-') + this->print(-(unsigned long)n, base);
+  return this->print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buffer[33];
+  return this->write(ultoa(n, buffer, base < 2 ? 10 : base));
+}
+
+size_t Print::print(double n, int digits) {
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, n);
+  return this->write(buffer);
+}
+
+int HostSerial::available() {
+  return host.serial_in_head - host.serial_in_tail;
+}
+
+int HostSerial::read() {
+  if (host.serial_in_tail == host.serial_in_head)
+    return -1;
+  return (uint8_t)host.serial_in[host.serial_in_tail++];
+}
+
+size_t HostSerial::write(uint8_t c) {
+  if (host.serial_out)
+    fputc(c, host.serial_out);
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size) {
+  if (host.serial_out)
+    fwrite(buffer, 1, size, host.serial_out);
+  return size;
+}
+
+void host_serial_input(const char *text) {
+  size_t len = strlen(text);
+  if (host.serial_in_tail == host.serial_in_head)
+    host.serial_in_head = host.serial_in_tail = 0;
+  if (host.serial_in_head + len > HOST_SERIAL_INPUT)
+    len = HOST_SERIAL_INPUT - host.serial_in_head;
+  memcpy(host.serial_in + host.serial_in_head, text, len);
+  host.serial_in_head += len;
+}
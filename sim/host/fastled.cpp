@@ -0,0 +1,381 @@
+// Host stand-in for FastLED: waveforms, noise, HSV, palettes and show()
+
+#include "FastLED.h"
+
+CFastLED FastLED;
+uint16_t rand16seed = 1337;
+
+// Waveforms, as lib8tion's sin16_C and sin8_C
+
+int16_t sin16(uint16_t theta) {
+  static const uint16_t base[] = { 0, 6393, 12539, 18204, 23170, 27245, 30273, 32137 };
+  static const uint8_t slope[] = { 49, 48, 44, 38, 31, 23, 14, 4 };
+
+  uint16_t offset = (theta & 0x3FFF) >> 3;
+  if (theta & 0x4000)
+    offset = 2047 - offset;
+
+  uint8_t section = offset / 256;
+  uint8_t secoffset8 = (uint8_t)offset / 2;
+  int16_t y = slope[section] * secoffset8 + base[section];
+  if (theta & 0x8000)
+    y = -y;
+  return y;
+}
+
+uint8_t sin8(uint8_t theta) {
+  static const uint8_t b_m16_interleave[] = { 0, 49, 49, 41, 90, 27, 117, 10 };
+
+  uint8_t offset = theta;
+  if (theta & 0x40)
+    offset = 255 - offset;
+  offset &= 0x3F;
+
+  uint8_t secoffset = offset & 0x0F;
+  if (theta & 0x40)
+    secoffset++;
+
+  uint8_t section = offset >> 4;
+  uint8_t b = b_m16_interleave[section * 2];
+  uint8_t m16 = b_m16_interleave[section * 2 + 1];
+  uint8_t mx = (m16 * secoffset) >> 4;
+  int8_t y = mx + b;
+  if (theta & 0x80)
+    y = -y;
+  return y + 128;
+}
+
+// Noise, as FastLED's noise.cpp
+
+static const uint8_t p[] = {
+  151, 160, 137, 91, 90, 15, 131, 13, 201, 95, 96, 53, 194, 233, 7, 225,
+  140, 36, 103, 30, 69, 142, 8, 99, 37, 240, 21, 10, 23, 190, 6, 148,
+  247, 120, 234, 75, 0, 26, 197, 62, 94, 252, 219, 203, 117, 35, 11, 32,
+  57, 177, 33, 88, 237, 149, 56, 87, 174, 20, 125, 136, 171, 168, 68, 175,
+  74, 165, 71, 134, 139, 48, 27, 166, 77, 146, 158, 231, 83, 111, 229, 122,
+  60, 211, 133, 230, 220, 105, 92, 41, 55, 46, 245, 40, 244, 102, 143, 54,
+  65, 25, 63, 161, 1, 216, 80, 73, 209, 76, 132, 187, 208, 89, 18, 169,
+  200, 196, 135, 130, 116, 188, 159, 86, 164, 100, 109, 198, 173, 186, 3, 64,
+  52, 217, 226, 250, 124, 123, 5, 202, 38, 147, 118, 126, 255, 82, 85, 212,
+  207, 206, 59, 227, 47, 16, 58, 17, 182, 189, 28, 42, 223, 183, 170, 213,
+  119, 248, 152, 2, 44, 154, 163, 70, 221, 153, 101, 155, 167, 43, 172, 9,
+  129, 22, 39, 253, 19, 98, 108, 110, 79, 113, 224, 232, 178, 185, 112, 104,
+  218, 246, 97, 228, 251, 34, 242, 193, 238, 210, 144, 12, 191, 179, 162, 241,
+  81, 51, 145, 235, 249, 14, 239, 107, 49, 192, 214, 31, 181, 199, 106, 157,
+  184, 84, 204, 176, 115, 121, 50, 45, 127, 4, 150, 254, 138, 236, 205, 93,
+  222, 114, 67, 29, 24, 72, 243, 141, 128, 195, 78, 66, 215, 61, 156, 180,
+  151,
+};
+
+#define P(x) p[(uint8_t)(x)]
+
+static int8_t grad8(uint8_t hash, int8_t x, int8_t y) {
+  int8_t u, v;
+  if (hash & 4) {
+    u = y;
+    v = x;
+  } else {
+    u = x;
+    v = y;
+  }
+  if (hash & 1)
+    u = -u;
+  if (hash & 2)
+    v = -v;
+  return avg7(u, v);
+}
+
+// Private to noise.cpp in FastLED, too
+static int8_t lerp7by8(int8_t a, int8_t b, fract8 frac) {
+  if (b > a) {
+    uint8_t delta = b - a;
+    return a + scale8(delta, frac);
+  }
+  uint8_t delta = a - b;
+  return a - scale8(delta, frac);
+}
+
+static int8_t inoise8_raw(uint16_t x, uint16_t y) {
+  uint8_t X = x >> 8;
+  uint8_t Y = y >> 8;
+
+  uint8_t A = P(X) + Y;
+  uint8_t AA = P(A);
+  uint8_t AB = P(A + 1);
+  uint8_t B = P(X + 1) + Y;
+  uint8_t BA = P(B);
+  uint8_t BB = P(B + 1);
+
+  uint8_t u = x;
+  uint8_t v = y;
+  int8_t xx = ((uint8_t)x >> 1) & 0x7F;
+  int8_t yy = ((uint8_t)y >> 1) & 0x7F;
+  const uint8_t N = 0x80;
+
+  u = ease8InOutQuad(u);
+  v = ease8InOutQuad(v);
+
+  int8_t X1 = lerp7by8(grad8(P(AA), xx, yy), grad8(P(BA), xx - N, yy), u);
+  int8_t X2 = lerp7by8(grad8(P(AB), xx, yy - N), grad8(P(BB), xx - N, yy - N), u);
+  return lerp7by8(X1, X2, v);
+}
+
+uint8_t inoise8(uint16_t x, uint16_t y) {
+  int8_t n = inoise8_raw(x, y);
+  n += 64;
+  return qadd8(n, n);
+}
+
+// Colors
+
+void hsv2rgb_rainbow(const CHSV &hsv, CRGB &rgb) {
+  const uint8_t K255 = 255;
+  const uint8_t K171 = 171;
+  const uint8_t K170 = 170;
+  const uint8_t K85 = 85;
+
+  uint8_t hue = hsv.hue;
+  uint8_t sat = hsv.sat;
+  uint8_t val = hsv.val;
+
+  uint8_t offset8 = (hue & 0x1F) << 3;
+  uint8_t third = scale8(offset8, 256 / 3);
+  uint8_t r, g, b;
+
+  if (!(hue & 0x80)) {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) {
+        r = K255 - third; g = third; b = 0;
+      } else {
+        r = K171; g = K85 + third; b = 0;
+      }
+    } else {
+      if (!(hue & 0x20)) {
+        uint8_t twothirds = scale8(offset8, (256 * 2) / 3);
+        r = K171 - twothirds; g = K170 + third; b = 0;
+      } else {
+        r = 0; g = K255 - third; b = third;
+      }
+    }
+  } else {
+    if (!(hue & 0x40)) {
+      if (!(hue & 0x20)) {
+        uint8_t twothirds = scale8(offset8, (256 * 2) / 3);
+        r = 0; g = K171 - twothirds; b = K85 + twothirds;
+      } else {
+        r = third; g = 0; b = K255 - third;
+      }
+    } else {
+      if (!(hue & 0x20)) {
+        r = K85 + third; g = 0; b = K171 - third;
+      } else {
+        r = K170 + third; g = 0; b = K85 - third;
+      }
+    }
+  }
+
+  if (sat != 255) {
+    if (sat == 0) {
+      r = g = b = 255;
+    } else {
+      uint8_t desat = 255 - sat;
+      desat = scale8_video(desat, desat);
+      uint8_t satscale = 255 - desat;
+      if (r) r = scale8(r, satscale);
+      if (g) g = scale8(g, satscale);
+      if (b) b = scale8(b, satscale);
+      r += desat;
+      g += desat;
+      b += desat;
+    }
+  }
+
+  if (val != 255) {
+    val = scale8_video(val, val);
+    if (val == 0) {
+      r = g = b = 0;
+    } else {
+      if (r) r = scale8(r, val);
+      if (g) g = scale8(g, val);
+      if (b) b = scale8(b, val);
+    }
+  }
+
+  rgb.r = r;
+  rgb.g = g;
+  rgb.b = b;
+}
+
+CRGB &nblend(CRGB &existing, const CRGB &overlay, fract8 amountOfOverlay) {
+  if (amountOfOverlay == 0)
+    return existing;
+  if (amountOfOverlay == 255) {
+    existing = overlay;
+    return existing;
+  }
+  existing.r = blend8(existing.r, overlay.r, amountOfOverlay);
+  existing.g = blend8(existing.g, overlay.g, amountOfOverlay);
+  existing.b = blend8(existing.b, overlay.b, amountOfOverlay);
+  return existing;
+}
+
+void fill_solid(CRGB *leds, int num_leds, const CRGB &color) {
+  for (int i = 0; i < num_leds; i++)
+    leds[i] = color;
+}
+
+void fill_rainbow(CRGB *leds, int num_leds, uint8_t initialhue, uint8_t deltahue) {
+  CHSV hsv(initialhue, 240, 255);
+  for (int i = 0; i < num_leds; i++) {
+    leds[i] = hsv;
+    hsv.hue += deltahue;
+  }
+}
+
+void nscale8(CRGB *leds, uint16_t num_leds, uint8_t scale) {
+  for (uint16_t i = 0; i < num_leds; i++)
+    leds[i].nscale8(scale);
+}
+
+void fadeToBlackBy(CRGB *leds, uint16_t num_leds, uint8_t fadeBy) {
+  nscale8(leds, num_leds, 255 - fadeBy);
+}
+
+// Palettes
+
+const TProgmemRGBPalette16 PartyColors_p = {
+  0x5500AB, 0x84007C, 0xB5004B, 0xE5001B,
+  0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+  0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E,
+  0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9,
+};
+
+const TProgmemRGBPalette16 RainbowColors_p = {
+  0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00,
+  0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+  0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5,
+  0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B,
+};
+
+CRGBPalette16 &CRGBPalette16::operator=(const TProgmemRGBPalette16 &rhs) {
+  for (uint8_t i = 0; i < 16; i++)
+    this->entries[i] = CRGB(rhs[i]);
+  return *this;
+}
+
+static void fill_gradient_RGB(CRGB *leds, uint16_t startpos, CRGB startcolor, uint16_t endpos, CRGB endcolor) {
+  if (endpos < startpos) {
+    uint16_t t = endpos;
+    CRGB tc = endcolor;
+    endcolor = startcolor;
+    endpos = startpos;
+    startpos = t;
+    startcolor = tc;
+  }
+
+  int16_t rdistance87 = (endcolor.r - startcolor.r) << 7;
+  int16_t gdistance87 = (endcolor.g - startcolor.g) << 7;
+  int16_t bdistance87 = (endcolor.b - startcolor.b) << 7;
+
+  uint16_t pixeldistance = endpos - startpos;
+  int16_t divisor = pixeldistance ? pixeldistance : 1;
+
+  int16_t rdelta87 = (rdistance87 / divisor) * 2;
+  int16_t gdelta87 = (gdistance87 / divisor) * 2;
+  int16_t bdelta87 = (bdistance87 / divisor) * 2;
+
+  uint16_t r88 = startcolor.r << 8;
+  uint16_t g88 = startcolor.g << 8;
+  uint16_t b88 = startcolor.b << 8;
+  for (uint16_t i = startpos; i <= endpos; i++) {
+    leds[i] = CRGB(r88 >> 8, g88 >> 8, b88 >> 8);
+    r88 += rdelta87;
+    g88 += gdelta87;
+    b88 += bdelta87;
+  }
+}
+
+// Gradient palettes are (index, r, g, b) entries, ending at index 255
+CRGBPalette16 &CRGBPalette16::operator=(TProgmemRGBGradientPalette_bytes progpal) {
+  const uint8_t *entry = progpal;
+  uint16_t count = 0;
+  do {
+    count++;
+  } while (entry[(count - 1) * 4] != 255);
+
+  int8_t lastSlotUsed = -1;
+  CRGB rgbstart(entry[1], entry[2], entry[3]);
+  int indexstart = 0;
+  while (indexstart < 255) {
+    entry += 4;
+    int indexend = entry[0];
+    CRGB rgbend(entry[1], entry[2], entry[3]);
+    uint8_t istart8 = indexstart / 16;
+    uint8_t iend8 = indexend / 16;
+    if (count < 16) {
+      if (istart8 <= lastSlotUsed && lastSlotUsed < 15) {
+        istart8 = lastSlotUsed + 1;
+        if (iend8 < istart8)
+          iend8 = istart8;
+      }
+      lastSlotUsed = iend8;
+    }
+    fill_gradient_RGB(this->entries, istart8, rgbstart, iend8, rgbend);
+    indexstart = indexend;
+    rgbstart = rgbend;
+  }
+  return *this;
+}
+
+CRGB ColorFromPalette(const CRGBPalette16 &pal, uint8_t index, uint8_t brightness, TBlendType blendType) {
+  uint8_t hi4 = index >> 4;
+  uint8_t lo4 = index & 0x0F;
+  const CRGB *entry = &pal.entries[hi4];
+
+  uint8_t red1 = entry->r;
+  uint8_t green1 = entry->g;
+  uint8_t blue1 = entry->b;
+
+  if (lo4 && blendType != NOBLEND) {
+    entry = hi4 == 15 ? &pal.entries[0] : entry + 1;
+    uint8_t f2 = lo4 << 4;
+    uint8_t f1 = 255 - f2;
+    red1 = scale8(red1, f1) + scale8(entry->r, f2);
+    green1 = scale8(green1, f1) + scale8(entry->g, f2);
+    blue1 = scale8(blue1, f1) + scale8(entry->b, f2);
+  }
+
+  if (brightness != 255) {
+    if (brightness) {
+      brightness++;
+      red1 = scale8(red1, brightness);
+      green1 = scale8(green1, brightness);
+      blue1 = scale8(blue1, brightness);
+    } else {
+      red1 = green1 = blue1 = 0;
+    }
+  }
+
+  return CRGB(red1, green1, blue1);
+}
+
+// Output
+
+void host_write_frame(FILE *out, uint32_t micros, const CRGB *leds, int num_leds) {
+  uint8_t header[6] = {
+    (uint8_t)micros, (uint8_t)(micros >> 8), (uint8_t)(micros >> 16), (uint8_t)(micros >> 24),
+    (uint8_t)num_leds, (uint8_t)(num_leds >> 8),
+  };
+  fwrite(header, 1, sizeof(header), out);
+  for (int i = 0; i < num_leds; i++)
+    fwrite(leds[i].raw, 1, 3, out);
+}
+
+void CFastLED::show() {
+  host.frame_count++;
+  if (host.frames && host.leds)
+    host_write_frame(host.frames, micros(), host.leds, host.num_leds);
+  host_charge(host.show_micros);
+  if (host.on_show)
+    host.on_show();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+// State of the simulated board, shared by the stand-in libraries and the
+// harness that drives the firmware.  One Host per tube: the mesh simulator
+// loads each tube as its own copy of the firmware library.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define HOST_PINS 64
+#define HOST_SERIAL_INPUT 4096
+#define HOST_RADIO_FIFO 3             // the NRF24's RX FIFO depth
+#define HOST_RADIO_PAYLOAD 32
+#define HOST_RADIO_SENT 64            // sent packets waiting for the harness
+
+struct CRGB;
+
+typedef struct {
+  uint8_t data[HOST_RADIO_PAYLOAD];
+  uint8_t len;
+  uint64_t start;                     // simulated micros the packet went on air...
+  uint64_t end;                       // ...and finished
+} HostPacket;
+
+// The NRF24 as seen from its pins: it only hears packets in RX mode, and
+// send() leaves it in TX mode until hasData() or startRx() switch it back.
+typedef struct {
+  bool present;
+  bool initialized;
+  bool rx_mode;
+  uint8_t channel;
+  HostPacket fifo[HOST_RADIO_FIFO];
+  uint8_t fifo_count;
+  HostPacket sent[HOST_RADIO_SENT];
+  uint8_t sent_count;
+
+  uint32_t settle_micros;             // TX PLL settling before each send
+  uint32_t airtime_micros;            // on air, per packet
+  uint32_t spi_micros;                // to load or read one payload
+  uint32_t handle_micros;             // the firmware's CPU time for each packet it handles
+
+  uint32_t sends;
+  uint32_t received;
+  uint32_t lost_not_listening;        // arrived while in TX mode
+  uint32_t lost_fifo_full;
+} HostRadio;
+
+typedef struct {
+  uint64_t clock;                     // simulated micros since power on
+  uint32_t seed;
+
+  uint8_t pins[HOST_PINS];            // digitalRead levels
+  uint16_t analog[HOST_PINS];
+  void (*isr[HOST_PINS])();
+  uint8_t radio_irq_pin;
+
+  // Serial
+  FILE *serial_out;                   // NULL to discard
+  char serial_in[HOST_SERIAL_INPUT];
+  size_t serial_in_head;
+  size_t serial_in_tail;
+
+  // LEDs
+  CRGB *leds;
+  int num_leds;
+  FILE *frames;                       // NULL to discard
+  uint32_t frame_count;
+  uint32_t show_micros;               // charged per FastLED.show(), for the frame's render and output
+  uint32_t max_power_mw;
+  void (*on_show)();                  // called after each frame, for tests
+
+  // I2C and the SSD1306
+  bool lcd_present;
+  uint32_t i2c_clock;
+  uint64_t i2c_bytes;
+  uint32_t i2c_transactions;
+
+  HostRadio radio;
+
+  uint32_t arm_demcr;
+  uint32_t arm_dwt_ctrl;
+} Host;
+
+extern Host host;
+
+// Power on: clears the board and seeds it
+void host_reset(uint32_t seed);
+// Moves the clock forward, as if the CPU were busy
+void host_charge(uint32_t micros);
+uint32_t host_seed();
+uint32_t host_cycles();
+
+// Queues characters to be read from Serial
+void host_serial_input(const char *text);
+
+// Hands a received packet to the radio.  Returns false if it was lost
+// because the radio wasn't listening or its FIFO was full.  Raises the IRQ.
+bool host_radio_receive(const uint8_t *data, uint8_t len);
+// Takes the oldest packet the firmware sent, or returns false
+bool host_radio_take(HostPacket *packet);
+// Called by the firmware for each packet it handles (RADIO_HANDLED)
+void host_radio_handled();
+
+// Frame files are a sequence of records: uint32 micros, uint16 LEDs, then
+// 3 bytes of RGB per LED (all little-endian)
+void host_write_frame(FILE *out, uint32_t micros, const CRGB *leds, int num_leds);
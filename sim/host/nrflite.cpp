@@ -0,0 +1,116 @@
+// Host stand-in for NRFLite, over the simulated NRF24 in host.radio
+
+#include "NRFLite.h"
+
+uint8_t NRFLite::init(uint8_t radioId, uint8_t cePin, uint8_t csnPin, Bitrates bitrate, uint8_t channel, uint8_t callSetup) {
+  HostRadio &radio = host.radio;
+  host_charge(radio.spi_micros);
+  if (!radio.present)
+    return 0;
+
+  radio.initialized = true;
+  radio.channel = channel;
+  radio.fifo_count = 0;
+  this->startRx();
+  return 1;
+}
+
+uint8_t NRFLite::send(uint8_t toRadioId, void *data, uint8_t length, SendType sendType) {
+  HostRadio &radio = host.radio;
+  if (!radio.initialized)
+    return 0;
+
+  // Load the payload, switch to TX, and wait for it to go out
+  host_charge(radio.spi_micros);
+  radio.rx_mode = false;
+
+  HostPacket packet;
+  memcpy(packet.data, data, length);
+  packet.len = length;
+  packet.start = host.clock + radio.settle_micros;
+  packet.end = packet.start + radio.airtime_micros;
+  host.clock = packet.end;
+
+  if (radio.sent_count == HOST_RADIO_SENT) {
+    memmove(radio.sent, radio.sent + 1, (HOST_RADIO_SENT - 1) * sizeof(HostPacket));
+    radio.sent_count--;
+  }
+  radio.sent[radio.sent_count++] = packet;
+  radio.sends++;
+  return 1;
+}
+
+void NRFLite::startRx() {
+  HostRadio &radio = host.radio;
+  if (radio.rx_mode)
+    return;
+  radio.rx_mode = true;
+  host_charge(radio.settle_micros);
+}
+
+uint8_t NRFLite::hasData(uint8_t usingInterrupts) {
+  if (!host.radio.initialized)
+    return 0;
+  this->startRx();
+  return this->hasDataISR();
+}
+
+uint8_t NRFLite::hasDataISR() {
+  HostRadio &radio = host.radio;
+  return radio.fifo_count ? radio.fifo[0].len : 0;
+}
+
+void NRFLite::readData(void *data) {
+  HostRadio &radio = host.radio;
+  host_charge(radio.spi_micros);
+  if (!radio.fifo_count)
+    return;
+
+  memcpy(data, radio.fifo[0].data, radio.fifo[0].len);
+  radio.fifo_count--;
+  memmove(radio.fifo, radio.fifo + 1, radio.fifo_count * sizeof(HostPacket));
+}
+
+void NRFLite::whatHappened(uint8_t &txOk, uint8_t &txFail, uint8_t &rxReady) {
+  txOk = !host.radio.rx_mode;
+  txFail = 0;
+  rxReady = host.radio.fifo_count > 0;
+}
+
+bool host_radio_receive(const uint8_t *data, uint8_t len) {
+  HostRadio &radio = host.radio;
+  if (!radio.initialized || !radio.rx_mode) {
+    radio.lost_not_listening++;
+    return false;
+  }
+  if (radio.fifo_count == HOST_RADIO_FIFO) {
+    radio.lost_fifo_full++;
+    return false;
+  }
+
+  HostPacket &packet = radio.fifo[radio.fifo_count++];
+  memcpy(packet.data, data, len);
+  packet.len = len;
+  packet.start = packet.end = host.clock;
+  radio.received++;
+
+  // The IRQ line falls when the FIFO stops being empty
+  if (radio.fifo_count == 1 && host.radio_irq_pin && host.isr[host.radio_irq_pin])
+    host.isr[host.radio_irq_pin]();
+  return true;
+}
+
+void host_radio_handled() {
+  host_charge(host.radio.handle_micros);
+}
+
+bool host_radio_take(HostPacket *packet) {
+  HostRadio &radio = host.radio;
+  if (!radio.sent_count)
+    return false;
+
+  *packet = radio.sent[0];
+  radio.sent_count--;
+  memmove(radio.sent, radio.sent + 1, radio.sent_count * sizeof(HostPacket));
+  return true;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Host stand-in for muwerk's ustd::array (included, but not used on host)
+
+#include "Arduino.h"
@@ -0,0 +1,115 @@
+// Host stand-ins for Wire, SPI and the SSD1306 display
+
+#include "Wire.h"
+#include "SPI.h"
+#include "Adafruit_SSD1306.h"
+
+TwoWire Wire;
+SPIClass SPI;
+
+void TwoWire::beginTransmission(uint8_t address) {
+  this->length = 0;
+  this->transmitting = true;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (!this->transmitting || this->length == WIRE_BUFFER_SIZE)
+    return 0;
+  this->buffer[this->length++] = data;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool stop) {
+  this->transmitting = false;
+
+  // Address and data, 9 bits a byte, plus start and stop
+  uint32_t bytes = this->length + 1;
+  uint32_t bits = bytes * 9 + 2;
+  host_charge((uint64_t)bits * 1000000 / host.i2c_clock);
+  host.i2c_bytes += bytes;
+  host.i2c_transactions++;
+  return host.lcd_present ? 0 : 2;
+}
+
+// SSD1306
+
+bool Adafruit_SSD1306::begin(uint8_t switchvcc, uint8_t i2caddr, bool reset, bool periphBegin) {
+  if (!this->buffer)
+    this->buffer = (uint8_t *)malloc(this->w * ((this->h + 7) / 8));
+  if (!this->buffer)
+    return false;
+  this->address = i2caddr;
+  this->clearDisplay();
+
+  // The library's init sequence is about 25 single-byte commands
+  for (uint8_t i = 0; i < 25; i++)
+    this->ssd1306_command(0xE3);  // NOP
+  return host.lcd_present;
+}
+
+void Adafruit_SSD1306::ssd1306_command(uint8_t c) {
+  this->wire->beginTransmission(this->address);
+  this->wire->write(0x00);
+  this->wire->write(c);
+  this->wire->endTransmission();
+}
+
+void Adafruit_SSD1306::clearDisplay() {
+  memset(this->buffer, 0, this->w * ((this->h + 7) / 8));
+}
+
+void Adafruit_SSD1306::display() {
+  const uint8_t commands[] = { 0x22, 0, 0xFF, 0x21, 0 };
+  for (uint8_t i = 0; i < sizeof(commands); i++)
+    this->ssd1306_command(commands[i]);
+  this->ssd1306_command(this->w - 1);
+
+  uint16_t count = this->w * ((this->h + 7) / 8);
+  uint8_t *ptr = this->buffer;
+  while (count) {
+    this->wire->beginTransmission(this->address);
+    this->wire->write(0x40);
+    for (uint8_t n = 1; n < WIRE_BUFFER_SIZE && count; n++, count--)
+      this->wire->write(*ptr++);
+    this->wire->endTransmission();
+  }
+}
+
+void Adafruit_SSD1306::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || x >= this->w || y < 0 || y >= this->h)
+    return;
+  uint8_t &byte = this->buffer[x + (y / 8) * this->w];
+  uint8_t bit = 1 << (y & 7);
+  switch (color) {
+    case WHITE: byte |= bit; break;
+    case BLACK: byte &= ~bit; break;
+    case INVERSE: byte ^= bit; break;
+  }
+}
+
+size_t Adafruit_SSD1306::write(uint8_t c) {
+  if (c == '\n') {
+    this->cursor_x = 0;
+    this->cursor_y += this->text_size * 8;
+    return 1;
+  }
+  if (c == '\r')
+    return 1;
+
+  // 5 columns of 7 rows, from the character code, and a blank column
+  for (uint8_t col = 0; col < 6; col++) {
+    uint8_t bits = (col == 5 || c == ' ') ? 0 : ((c * 0x9E + col * 0x35) ^ (c >> 1)) & 0x7F;
+    for (uint8_t row = 0; row < 8; row++) {
+      bool on = bits & (1 << row);
+      if (!on && this->text_bg == this->text_color)
+        continue;
+      uint16_t color = on ? this->text_color : this->text_bg;
+      for (uint8_t sx = 0; sx < this->text_size; sx++) {
+        for (uint8_t sy = 0; sy < this->text_size; sy++)
+          this->drawPixel(this->cursor_x + col * this->text_size + sx, this->cursor_y + row * this->text_size + sy, color);
+      }
+    }
+  }
+  this->cursor_x += 6 * this->text_size;
+  return 1;
+}
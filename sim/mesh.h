@@ -0,0 +1,46 @@
+#pragma once
+
+// The interface between the mesh simulator and each tube.  mesh_tube.cpp
+// builds the firmware as a shared library that exports these functions;
+// mesh_sim loads one private copy of it per tube, so every tube has its
+// own globals, its own Host and its own clock.
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define MESH_PAYLOAD 32
+
+typedef struct {
+  uint8_t data[MESH_PAYLOAD];
+  uint8_t len;
+  uint64_t start;          // the tube's micros when the packet went on air...
+  uint64_t end;            // ...and finished
+  uint8_t sender;          // tubeId in the packet
+  uint8_t origin;          // the tube that first sent it
+  uint8_t seq;
+  bool relayed;
+} MeshPacket;
+
+typedef struct {
+  uint64_t clock;          // the tube's micros since power on
+  uint8_t tube_id;
+  uint8_t master_id;       // 0 while it leads
+  uint16_t bpm;
+  uint64_t phase;          // beat phase at the time asked for, in 1/2^24 fracs
+  uint32_t ring_dropped;
+} MeshStatus;
+
+extern "C" {
+  // Powers on and runs setup()
+  typedef void (*MeshBootFn)(uint32_t seed);
+  // Runs loop() until the tube's clock reaches `until`
+  typedef void (*MeshRunFn)(uint64_t until);
+  // Takes the oldest packet the tube sent, or returns false
+  typedef bool (*MeshTakeFn)(MeshPacket *packet);
+  // Hands the radio a packet heard now; false if it wasn't listening or was full
+  typedef bool (*MeshReceiveFn)(const uint8_t *data, uint8_t len);
+  // The tube's state, with its beat phase extrapolated to `at` (the tube's micros)
+  typedef void (*MeshStatusFn)(uint64_t at, MeshStatus *status);
+  // Serial output goes to `out`, or nowhere if NULL
+  typedef void (*MeshSerialFn)(FILE *out);
+}
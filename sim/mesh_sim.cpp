@@ -0,0 +1,492 @@
+// Runs a fleet of tubes on one simulated radio channel.  Each tube is its
+// own copy of the firmware (build/mesh_tube.so, see mesh.h), powered on at
+// a random moment within the first 3 seconds, with a crystal off by a few
+// ppm.  The channel delivers a packet to every tube that can hear the
+// sender, unless the receiver was itself sending (half duplex), another
+// packet it could hear overlapped in the air (a collision), or it missed
+// the packet at random.
+//
+//   mesh_sim [options]
+//     --tubes N        how many (default 20)
+//     --topology T     cluster: every tube hears every other (default)
+//                      line: a row, each tube hearing two either side
+//                      daisy: a chain, each tube hearing only its neighbours
+//     --loss P         percent of packets each receiver misses (default 0)
+//     --seconds S      simulated time after the last tube powers on (default 60)
+//     --seed N         random seed (default 1)
+//     --ppm P          crystals are off by up to +/-P ppm (default 50)
+//     --lib FILE       the tube library (default mesh_tube.so beside mesh_sim)
+//     --serial I       print tube I's serial output
+//     --csv            print one line of CSV; --header prints the names first
+//     --check          exit 1 unless the election converged, every tube heard
+//                      the leader and the beats agree within a few fracs
+//
+// Reports how long the master election took to converge, the traffic
+// (packets and airtime per second, relays), what happened to each
+// reception, how many tubes each of the leader's updates reached and how
+// fast, and the worst spread of the beat phase between tubes.
+
+#include <dlfcn.h>
+#include <libgen.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mesh.h"
+
+#define MESH_QUANTUM 50                   // micros the tubes run in lockstep
+#define MESH_POWER_ON_MICROS 3000000      // tubes power on within this
+#define MESH_AGREE_MICROS 10000           // how often the election is checked
+#define MESH_SPREAD_MICROS 100000         // how often the beat spread is measured
+#define MESH_SETTLE_MICROS 5000000        // after converging, before the spread counts
+#define MESH_CHECK_SPREAD_FRACS 4
+
+enum Topology { Cluster, Line, Daisy };
+
+struct Tube {
+  void *handle;
+  MeshBootFn boot;
+  MeshRunFn run;
+  MeshTakeFn take;
+  MeshReceiveFn receive;
+  MeshStatusFn status;
+  MeshSerialFn serial;
+
+  uint64_t on;           // global micros of power on
+  uint64_t up;           // ...and when setup() finished, with the radio on
+  int32_t ppm;
+  bool booted;
+
+  // The tube's micros at a global time, and back
+  uint64_t local(uint64_t global) {
+    if (global <= this->on)
+      return 0;
+    int64_t t = global - this->on;
+    return t + t * this->ppm / 1000000;
+  }
+
+  uint64_t global(uint64_t local) {
+    int64_t t = local;
+    return this->on + t - t * this->ppm / 1000000;
+  }
+};
+
+struct Air {
+  MeshPacket packet;
+  int from;
+  uint64_t start, end;   // global
+  bool done;
+};
+
+// One originated message and when each tube first got a copy
+struct Flood {
+  int from;
+  uint8_t origin;
+  uint64_t start;
+  std::vector<uint64_t> reached;
+};
+
+struct Stats {
+  uint32_t sent = 0;
+  uint32_t relayed = 0;
+  uint64_t airtime = 0;
+  uint32_t delivered = 0;
+  uint32_t collided = 0;
+  uint32_t half_duplex = 0;
+  uint32_t lost = 0;
+  uint32_t not_listening = 0;
+
+  // Receptions of unrelayed messages from power on, when several tubes
+  // lead at once
+  uint32_t original_heard = 0;
+  uint32_t original_collided = 0;
+};
+
+static uint64_t rng_state;
+
+static uint32_t rng() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state >> 16;
+}
+
+static Topology topology = Cluster;
+
+static bool hears(int a, int b) {
+  switch (topology) {
+    case Line:
+      return abs(a - b) <= 2;
+    case Daisy:
+      return abs(a - b) == 1;
+    default:
+      return true;
+  }
+}
+
+static const char *topology_name(Topology t) {
+  return t == Line ? "line" : (t == Daisy ? "daisy" : "cluster");
+}
+
+// dlopen() returns the same handle for the same file, so each tube loads
+// its own copy
+static bool load_tube(Tube &tube, const std::vector<char> &lib) {
+  char path[] = "/tmp/mesh_tube_XXXXXX.so";
+  int fd = mkstemps(path, 3);
+  if (fd < 0 || write(fd, lib.data(), lib.size()) != (ssize_t)lib.size()) {
+    perror(path);
+    return false;
+  }
+  close(fd);
+  tube.handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  unlink(path);
+  if (!tube.handle) {
+    fprintf(stderr, "%s\n", dlerror());
+    return false;
+  }
+
+  tube.boot = (MeshBootFn)dlsym(tube.handle, "mesh_boot");
+  tube.run = (MeshRunFn)dlsym(tube.handle, "mesh_run");
+  tube.take = (MeshTakeFn)dlsym(tube.handle, "mesh_take");
+  tube.receive = (MeshReceiveFn)dlsym(tube.handle, "mesh_receive");
+  tube.status = (MeshStatusFn)dlsym(tube.handle, "mesh_status");
+  tube.serial = (MeshSerialFn)dlsym(tube.handle, "mesh_serial");
+  if (!tube.boot || !tube.run || !tube.take || !tube.receive || !tube.status || !tube.serial) {
+    fprintf(stderr, "missing mesh functions in the tube library\n");
+    return false;
+  }
+  return true;
+}
+
+static bool read_file(const char *path, std::vector<char> &out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    out.insert(out.end(), buffer, buffer + n);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  int num_tubes = 20;
+  int loss = 0;
+  double seconds = 60;
+  uint32_t seed = 1;
+  int max_ppm = 50;
+  std::string lib_path;
+  int serial_tube = -1;
+  bool csv = false, header = false, check = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool more = i + 1 < argc;
+    if (arg == "--tubes" && more)
+      num_tubes = atoi(argv[++i]);
+    else if (arg == "--topology" && more) {
+      std::string t = argv[++i];
+      if (t == "cluster")
+        topology = Cluster;
+      else if (t == "line")
+        topology = Line;
+      else if (t == "daisy")
+        topology = Daisy;
+      else {
+        fprintf(stderr, "unknown topology %s\n", t.c_str());
+        return 2;
+      }
+    }
+    else if (arg == "--loss" && more)
+      loss = atoi(argv[++i]);
+    else if (arg == "--seconds" && more)
+      seconds = atof(argv[++i]);
+    else if (arg == "--seed" && more)
+      seed = strtoul(argv[++i], NULL, 0);
+    else if (arg == "--ppm" && more)
+      max_ppm = atoi(argv[++i]);
+    else if (arg == "--lib" && more)
+      lib_path = argv[++i];
+    else if (arg == "--serial" && more)
+      serial_tube = atoi(argv[++i]);
+    else if (arg == "--csv")
+      csv = true;
+    else if (arg == "--header")
+      header = true;
+    else if (arg == "--check")
+      check = true;
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (num_tubes < 2) {
+    fprintf(stderr, "need at least 2 tubes\n");
+    return 2;
+  }
+
+  if (lib_path.empty()) {
+    std::string self = argv[0];
+    lib_path = std::string(dirname(&self[0])) + "/mesh_tube.so";
+  }
+  std::vector<char> lib;
+  if (!read_file(lib_path.c_str(), lib))
+    return 1;
+  std::string lib_name = lib_path.substr(lib_path.rfind('/') + 1);
+  lib_name = lib_name.substr(0, lib_name.rfind(".so"));
+
+  rng_state = 0x9E3779B97F4A7C15ULL * (seed + 1);
+  std::vector<Tube> tubes(num_tubes);
+  uint64_t last_on = 0;
+  for (int i = 0; i < num_tubes; i++) {
+    Tube &tube = tubes[i];
+    if (!load_tube(tube, lib))
+      return 1;
+    tube.on = rng() % MESH_POWER_ON_MICROS;
+    tube.ppm = max_ppm ? (int32_t)(rng() % (2 * max_ppm + 1)) - max_ppm : 0;
+    tube.booted = false;
+    last_on = std::max(last_on, tube.on);
+  }
+  uint64_t end = last_on + (uint64_t)(seconds * 1000000);
+
+  Stats stats;
+  std::vector<Air> air;
+  std::vector<Flood> floods;
+  std::map<uint16_t, size_t> latest_flood;      // (origin, seq) -> index in floods
+  uint64_t last_disagree = 0;
+  bool agree = false;
+  std::vector<std::pair<uint64_t, double> > spreads;
+  std::vector<MeshStatus> status(num_tubes);
+  uint16_t bpm = 0;
+
+  for (uint64_t now = 0; now < end; now += MESH_QUANTUM) {
+    uint64_t next = now + MESH_QUANTUM;
+
+    for (int i = 0; i < num_tubes; i++) {
+      Tube &tube = tubes[i];
+      if (!tube.booted && tube.on <= now) {
+        tube.boot(seed * 1000 + i + 1);
+        if (i == serial_tube)
+          tube.serial(stdout);
+        tube.booted = true;
+        MeshStatus booted;
+        tube.status(0, &booted);
+        tube.up = tube.global(booted.clock);
+      }
+      if (!tube.booted)
+        continue;
+
+      tube.run(tube.local(next));
+      Air sent;
+      while (tube.take(&sent.packet)) {
+        sent.from = i;
+        sent.start = tube.global(sent.packet.start);
+        sent.end = tube.global(sent.packet.end);
+        sent.done = false;
+        air.push_back(sent);
+
+        if (sent.start < last_on)
+          continue;
+        stats.airtime += sent.end - sent.start;
+        if (sent.packet.relayed) {
+          stats.relayed++;
+          continue;
+        }
+        stats.sent++;
+        Flood flood;
+        flood.from = i;
+        flood.origin = sent.packet.origin;
+        flood.start = sent.start;
+        flood.reached.assign(num_tubes, 0);
+        flood.reached[i] = sent.start;
+        latest_flood[(sent.packet.origin << 8) | sent.packet.seq] = floods.size();
+        floods.push_back(flood);
+      }
+    }
+
+    // Everything that overlaps a packet that has finished is known by now:
+    // tubes only send from the present onwards
+    std::vector<size_t> finished;
+    for (size_t a = 0; a < air.size(); a++) {
+      if (!air[a].done && air[a].end <= next)
+        finished.push_back(a);
+    }
+    std::sort(finished.begin(), finished.end(), [&](size_t a, size_t b) { return air[a].end < air[b].end; });
+
+    for (size_t a : finished) {
+      Air &p = air[a];
+      p.done = true;
+      bool counted = p.start >= last_on;
+      auto flood = latest_flood.find((p.packet.origin << 8) | p.packet.seq);
+
+      for (int r = 0; r < num_tubes; r++) {
+        if (r == p.from || !hears(p.from, r) || !tubes[r].booted || tubes[r].up > p.end)
+          continue;
+
+        bool half_duplex = false, collided = false;
+        for (Air &q : air) {
+          if (&q == &p || q.start >= p.end || p.start >= q.end)
+            continue;
+          if (q.from == r)
+            half_duplex = true;
+          else if (hears(q.from, r))
+            collided = true;
+        }
+
+        if (!p.packet.relayed) {
+          stats.original_heard++;
+          if (collided && !half_duplex)
+            stats.original_collided++;
+        }
+
+        if (half_duplex) {
+          if (counted)
+            stats.half_duplex++;
+        } else if (collided) {
+          if (counted)
+            stats.collided++;
+        } else if ((int)(rng() % 100) < loss) {
+          if (counted)
+            stats.lost++;
+        } else if (!tubes[r].receive(p.packet.data, p.packet.len)) {
+          if (counted)
+            stats.not_listening++;
+        } else {
+          if (counted)
+            stats.delivered++;
+          if (flood != latest_flood.end()) {
+            Flood &f = floods[flood->second];
+            if (!f.reached[r])
+              f.reached[r] = p.end;
+          }
+        }
+      }
+    }
+
+    // Nothing still to finish can overlap packets this old
+    air.erase(std::remove_if(air.begin(), air.end(), [&](Air &p) { return p.done && p.end + 2000 < next; }), air.end());
+
+    if (next % MESH_AGREE_MICROS)
+      continue;
+
+    // The election has converged when every tube follows the highest ID
+    uint8_t leader = 0;
+    bool all_up = true;
+    for (int i = 0; i < num_tubes; i++) {
+      all_up = all_up && tubes[i].booted && tubes[i].up <= next;
+      if (tubes[i].booted) {
+        tubes[i].status(tubes[i].local(next), &status[i]);
+        leader = std::max(leader, status[i].tube_id);
+      }
+    }
+    agree = all_up;
+    for (int i = 0; i < num_tubes && agree; i++) {
+      uint8_t follows = status[i].master_id ? status[i].master_id : status[i].tube_id;
+      agree = follows == leader;
+    }
+    if (!agree)
+      last_disagree = next;
+
+    if (agree && next % MESH_SPREAD_MICROS == 0) {
+      int64_t lo = 0, hi = 0;
+      for (int i = 1; i < num_tubes; i++) {
+        int64_t d = (int64_t)(status[i].phase - status[0].phase);
+        lo = std::min(lo, d);
+        hi = std::max(hi, d);
+      }
+      spreads.push_back(std::make_pair(next, (hi - lo) / (double)(1 << 24)));
+      bpm = status[0].bpm;
+    }
+  }
+
+  // Results, counting from the last power on
+  double window = (end - last_on) / 1e6;
+  bool converged = agree;
+  double converge_ms = converged ? (std::max(last_disagree, last_on) + MESH_AGREE_MICROS - last_on) / 1000.0 : -1;
+  uint8_t leader = 0;
+  uint32_t ring_dropped = 0;
+  for (int i = 0; i < num_tubes; i++) {
+    leader = std::max(leader, status[i].tube_id);
+    ring_dropped += status[i].ring_dropped;
+  }
+
+  // The leader's updates since the election (or since the last power on, if
+  // it never converged): the share of the other tubes each reached, and how
+  // long after it went on air
+  uint64_t reach_from = converged ? std::max(last_disagree, last_on) : last_on;
+  uint64_t pairs = 0, reached = 0;
+  double latency_sum = 0, latency_max = 0;
+  for (Flood &f : floods) {
+    if (f.origin != leader || f.start < reach_from || f.start + 1000000 > end)
+      continue;
+    for (int i = 0; i < num_tubes; i++) {
+      if (i == f.from)
+        continue;
+      pairs++;
+      if (!f.reached[i])
+        continue;
+      reached++;
+      double latency = (f.reached[i] - f.start) / 1000.0;
+      latency_sum += latency;
+      latency_max = std::max(latency_max, latency);
+    }
+  }
+  double coverage = pairs ? 100.0 * reached / pairs : 0;
+  double latency = reached ? latency_sum / reached : 0;
+
+  // -1 if it never converged for long enough to measure
+  double spread = -1;
+  for (auto &s : spreads) {
+    if (converged && s.first >= reach_from + MESH_SETTLE_MICROS)
+      spread = std::max(spread, s.second);
+  }
+  double spread_ms = spread >= 0 && bpm ? spread * 60000.0 / bpm : -1;
+
+  double packets = stats.sent + stats.relayed;
+  uint32_t heard = stats.delivered + stats.collided + stats.half_duplex + stats.lost + stats.not_listening;
+  double collided_pct = heard ? 100.0 * stats.collided / heard : 0;
+  double original_collided_pct = stats.original_heard ? 100.0 * stats.original_collided / stats.original_heard : 0;
+  if (header)
+    printf("lib,tubes,topology,loss,seconds,converge_ms,leader,pps,airtime_ms_per_s,relays_per_s,"
+           "delivered,collided,half_duplex,lost,not_listening,ring_dropped,collided_pct,original_collided_pct,coverage,latency_ms,max_latency_ms,spread_fracs,spread_ms\n");
+  if (csv) {
+    printf("%s,%d,%s,%d,%.0f,%.0f,%u,%.1f,%.2f,%.1f,%u,%u,%u,%u,%u,%u,%.2f,%.2f,%.1f,%.2f,%.2f,%.2f,%.2f\n",
+           lib_name.c_str(), num_tubes, topology_name(topology), loss, window, converge_ms, leader,
+           packets / window, stats.airtime / 1000.0 / window, stats.relayed / window,
+           stats.delivered, stats.collided, stats.half_duplex, stats.lost, stats.not_listening, ring_dropped,
+           collided_pct, original_collided_pct, coverage, latency, latency_max, spread, spread_ms);
+  } else if (!header) {
+    printf("%d tubes, %s, %d%% loss, %.0fs after the last power on\n", num_tubes, topology_name(topology), loss, window);
+    if (converged)
+      printf("election: converged on %u, %.0fms after the last tube powered on\n", leader, converge_ms);
+    else
+      printf("election: not converged\n");
+    printf("traffic: %.1f packets/s, %.2fms/s of airtime, %.1f relays/s\n",
+           packets / window, stats.airtime / 1000.0 / window, stats.relayed / window);
+    printf("receptions: %u delivered, %u collided, %u half duplex, %u lost, %u not listening, %u dropped from rings\n",
+           stats.delivered, stats.collided, stats.half_duplex, stats.lost, stats.not_listening, ring_dropped);
+    printf("collisions: %.2f%% of receptions; %.2f%% of unrelayed messages since power on\n",
+           collided_pct, original_collided_pct);
+    printf("reach: the leader's updates reached %.1f%% of tubes, in %.2fms on average (%.2fms at worst)\n",
+           coverage, latency, latency_max);
+    if (spread >= 0)
+      printf("beat spread: %.2f fracs (%.2fms) at worst, from %.0fs after converging\n",
+             spread, spread_ms, MESH_SETTLE_MICROS / 1e6);
+    else
+      printf("beat spread: not measured\n");
+  }
+
+  if (check && (!converged || coverage < 100 || spread < 0 || spread > MESH_CHECK_SPREAD_FRACS)) {
+    fprintf(stderr, "mesh_sim: check failed\n");
+    return 1;
+  }
+  return 0;
+}
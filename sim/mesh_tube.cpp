@@ -0,0 +1,60 @@
+// One tube for the mesh simulator: the firmware built as a shared library
+// (with hidden visibility, so copies loaded side by side don't share
+// globals), exporting the functions in mesh.h.
+
+#include "tube.h"
+#include "mesh.h"
+
+#define MESH_EXPORT extern "C" __attribute__((visibility("default")))
+
+MESH_EXPORT void mesh_boot(uint32_t seed) {
+  host_reset(seed);
+  host.serial_out = NULL;
+  tube_boot();
+}
+
+MESH_EXPORT void mesh_run(uint64_t until) {
+  tube_run_until(until);
+}
+
+MESH_EXPORT bool mesh_take(MeshPacket *packet) {
+  HostPacket sent;
+  if (!host_radio_take(&sent))
+    return false;
+
+  memcpy(packet->data, sent.data, sent.len);
+  packet->len = sent.len;
+  packet->start = sent.start;
+  packet->end = sent.end;
+
+  RadioMessage message;
+  memcpy(&message, sent.data, min(sent.len, sizeof(message)));
+  packet->sender = message.tubeId;
+  packet->origin = messageOrigin(message);
+  packet->seq = message.seq;
+  packet->relayed = message.relayId != 0;
+  return true;
+}
+
+MESH_EXPORT bool mesh_receive(const uint8_t *data, uint8_t len) {
+  return host_radio_receive(data, len);
+}
+
+MESH_EXPORT void mesh_status(uint64_t at, MeshStatus *status) {
+  status->clock = host.clock;
+  status->tube_id = radio.tubeId;
+  status->master_id = radio.masterTubeId;
+  status->bpm = beats.bpm;
+  status->ring_dropped = _radio_ring.dropped;
+
+  // beats.phase() is as of the last beat update
+  uint64_t updated = host.clock - (uint32_t)(micros() - globalTimer.now_micros);
+  if (at >= updated)
+    status->phase = beats.phase() + beats.sub_fracs(at - updated);
+  else
+    status->phase = beats.phase() - beats.sub_fracs(updated - at);
+}
+
+MESH_EXPORT void mesh_serial(FILE *out) {
+  host.serial_out = out;
+}
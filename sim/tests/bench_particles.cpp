@@ -0,0 +1,144 @@
+// Cycles to animate and draw 20 live particles, for the parallel-array
+// ParticleSystem against the one-object-per-particle version it replaced
+// (kept here as Legacy*).  Both draw with the Blend pen, which doesn't depend
+// on draw order, so their frames must match.
+
+#include "tube.h"
+#include "tests/check.h"
+
+class LegacyParticle;
+typedef void (*LegacyParticleFn)(LegacyParticle *particle, CRGB strip[], uint8_t num_leds);
+
+class LegacyParticle {
+  public:
+    BeatFrame_24_8 born;
+    BeatFrame_24_8 lifetime;
+    BeatFrame_24_8 age = 0;
+    uint16_t position;
+    int16_t velocity = 0;
+    int16_t gravity = 0;
+    PenMode pen;
+    CRGB color;
+    uint16_t brightness = 192 << 8;
+    LegacyParticleFn drawFn;
+
+  LegacyParticle(uint16_t position, CRGB color, PenMode pen, uint32_t lifetime, LegacyParticleFn drawFn)
+    : lifetime(lifetime), position(position), pen(pen), color(color), drawFn(drawFn) {}
+
+  void update(BeatFrame_24_8 frame) {
+    this->age = frame - this->born;
+    this->position = udelta16(this->position, this->velocity);
+    this->velocity = delta16(this->velocity, this->gravity);
+  }
+
+  uint16_t age_frac16(BeatFrame_24_8 age) {
+    if (age >= this->lifetime)
+      return 65535;
+    return (age * 65536) / this->lifetime;
+  }
+
+  CRGB color_at(uint16_t age_frac) {
+    uint8_t brightness = scale8((uint8_t)(this->brightness >> 8), 255 - (age_frac >> 8));
+    return CRGB(scale8(this->color.r, brightness), scale8(this->color.g, brightness), scale8(this->color.b, brightness));
+  }
+};
+
+static void legacy_radius(LegacyParticle *particle, CRGB strip[], uint8_t num_leds, uint16_t pos, uint8_t radius, CRGB c, bool dim) {
+  for (int i = 0; i < radius; i++) {
+    uint8_t bright = dim ? ((radius-i) * 255) / radius : 255;
+    nscale8(&c, 1, bright);
+    uint8_t y = pos - i;
+    if (y < num_leds)
+      draw_with_pen(strip, y, c, particle->pen);
+    if (i == 0)
+      continue;
+    y = pos + i;
+    if (y < num_leds)
+      draw_with_pen(strip, y, c, particle->pen);
+  }
+}
+
+static void legacy_point(LegacyParticle *particle, CRGB strip[], uint8_t num_leds) {
+  CRGB c = particle->color_at(particle->age_frac16(particle->age));
+  draw_with_pen(strip, scale16(particle->position, num_leds-1), c, particle->pen);
+}
+
+static void legacy_flash(LegacyParticle *particle, CRGB strip[], uint8_t num_leds) {
+  CRGB c = particle->color_at(particle->age_frac16(particle->age));
+  for (int pos = 0; pos < num_leds; pos++)
+    draw_with_pen(strip, pos, c, particle->pen);
+}
+
+static void legacy_pop(LegacyParticle *particle, CRGB strip[], uint8_t num_leds) {
+  uint16_t age_frac = particle->age_frac16(particle->age);
+  uint8_t radius = scale16((sin16(age_frac/2) - 32768) * 2, 8);
+  legacy_radius(particle, strip, num_leds, scale16(particle->position, num_leds-1), radius, particle->color_at(age_frac), true);
+}
+
+static void legacy_beatbox(LegacyParticle *particle, CRGB strip[], uint8_t num_leds) {
+  uint16_t age_frac = particle->age_frac16(particle->age);
+  legacy_radius(particle, strip, num_leds, scale16(particle->position, num_leds-1), 5, particle->color_at(age_frac), false);
+}
+
+static const LegacyParticleFn legacy_fns[PARTICLE_KINDS] = { legacy_point, legacy_flash, legacy_pop, legacy_beatbox };
+
+#define PARTICLE_BENCH_FRAMES 20000
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+
+  LegacyParticle *legacy[MAX_PARTICLES];
+  for (uint8_t i = 0; i < MAX_PARTICLES; i++) {
+    uint16_t position = random16();
+    CRGB color = CHSV(random8(), 255, 255);
+    uint32_t lifetime = 1 << 30;  // all stay live
+    ParticleKind kind = (ParticleKind)(i % PARTICLE_KINDS);
+    if (kind == FlashParticle && i > 1)
+      kind = PointParticle;  // one flash is plenty
+
+    legacy[i] = new LegacyParticle(position, color, Blend, lifetime, legacy_fns[kind]);
+    legacy[i]->born = 0;
+    uint8_t p = particles.add(0, position, color, Blend, lifetime, kind);
+    particles.velocity[p] = legacy[i]->velocity = (int16_t)random16(200) - 100;
+  }
+
+  CRGB before[MAX_LEDS], after[MAX_LEDS];
+  uint64_t legacy_animate = 0, legacy_draw = 0, soa_animate = 0, soa_draw = 0;
+  uint32_t mismatches = 0;
+  for (uint32_t f = 1; f <= PARTICLE_BENCH_FRAMES; f++) {
+    BeatFrame_24_8 frame = f * 2;
+    fill_solid(before, NUM_LEDS, CRGB::Black);
+    fill_solid(after, NUM_LEDS, CRGB::Black);
+
+    uint32_t start = host_cycles();
+    for (uint8_t i = 0; i < MAX_PARTICLES; i++)
+      legacy[i]->update(frame);
+    uint32_t mid = host_cycles();
+    for (uint8_t i = 0; i < MAX_PARTICLES; i++)
+      legacy[i]->drawFn(legacy[i], before, NUM_LEDS);
+    uint32_t end = host_cycles();
+    legacy_animate += mid - start;
+    legacy_draw += end - mid;
+
+    start = host_cycles();
+    particles.animate(frame);
+    mid = host_cycles();
+    particles.draw(after, NUM_LEDS);
+    end = host_cycles();
+    soa_animate += mid - start;
+    soa_draw += end - mid;
+
+    if (memcmp(before, after, sizeof(before)))
+      mismatches++;
+  }
+
+  printf("particles,version,animate_cycles,draw_cycles,cycles_per_frame\n");
+  printf("%u,legacy,%llu,%llu,%llu\n", MAX_PARTICLES, (unsigned long long)(legacy_animate / PARTICLE_BENCH_FRAMES),
+    (unsigned long long)(legacy_draw / PARTICLE_BENCH_FRAMES), (unsigned long long)((legacy_animate + legacy_draw) / PARTICLE_BENCH_FRAMES));
+  printf("%u,soa,%llu,%llu,%llu\n", MAX_PARTICLES, (unsigned long long)(soa_animate / PARTICLE_BENCH_FRAMES),
+    (unsigned long long)(soa_draw / PARTICLE_BENCH_FRAMES), (unsigned long long)((soa_animate + soa_draw) / PARTICLE_BENCH_FRAMES));
+  CHECK_EQ(particles.length(), MAX_PARTICLES);
+  CHECK_EQ(mismatches, 0);
+  return check_status();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Checks for the host tests: a failed CHECK prints its line and the test
+// carries on, so one run shows every failure.  main() returns check_status().
+
+#include <stdio.h>
+
+static int check_failures = 0;
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+      check_failures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long check_a = (long long)(a), check_b = (long long)(b); \
+    if (check_a != check_b) { \
+      fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, check_a, check_b); \
+      check_failures++; \
+    } \
+  } while (0)
+
+static int check_status() {
+  if (check_failures)
+    fprintf(stderr, "%d checks failed\n", check_failures);
+  return check_failures ? 1 : 0;
+}
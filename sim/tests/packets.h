@@ -0,0 +1,33 @@
+#pragma once
+
+// Packets from other tubes, built the way Radio::sendCommandFrom() builds
+// them, for tests to hand to the simulated radio
+
+#include <string.h>
+
+static uint8_t packets_seq = 0;
+
+RadioMessage make_message(TubeId id, CommandId command, const void *data=NULL, uint8_t size=0) {
+  RadioMessage message;
+  message.tubeId = id;
+  message.relayId = 0;
+  message.command = command + (RADIO_WIRE_VERSION << 12);
+  message.seq = packets_seq++;
+  message.age = 0;
+  memset(message.data, 0, sizeof(message.data));
+  if (size)
+    memcpy(message.data, data, size);
+  message.crc = calculate_crc(message);
+  return message;
+}
+
+// A master's COMMAND_STATE
+RadioMessage make_state(TubeId id, TubeState &current, TubeState &next) {
+  uint8_t buffer[STATE_WIRE_SIZE];
+  uint8_t size = pack_states(current, next, buffer);
+  return make_message(id, COMMAND_STATE, buffer, size);
+}
+
+bool deliver(RadioMessage &message) {
+  return host_radio_receive((const uint8_t *)&message, sizeof(message));
+}
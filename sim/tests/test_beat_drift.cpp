@@ -0,0 +1,68 @@
+// Twelve simulated hours of beat clock, updated at the frame rate with
+// jitter and the odd long stall: the fixed-point anchor must stay within a
+// frac of the exact beat, across micros() wrapping around.  The per-frac
+// accumulator it replaced (LegacyBeats) is run alongside for comparison.
+
+#include "tube.h"
+#include "tests/check.h"
+
+class LegacyBeats {
+  public:
+    BeatFrame_24_8 frac = 0;
+    uint32_t accum = 0;
+    uint32_t micros_per_frac;
+
+  void sync(accum88 bpm) {
+    this->frac = 0;
+    this->accum = 0;
+    this->micros_per_frac = (uint32_t)(15360000000.0 / (float)bpm);
+  }
+
+  void update(uint32_t delta_micros) {
+    this->accum += delta_micros << 8;
+    while (this->accum > this->micros_per_frac) {
+      this->frac++;
+      this->accum -= this->micros_per_frac;
+    }
+  }
+};
+
+#define DRIFT_HOURS 12
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+
+  const accum88 tempos[] = { 120 << 8, (123 << 8) + 128, 174 << 8, (89 << 8) + 77 };
+  printf("bpm,hours,expected_fracs,anchor_error,legacy_error\n");
+  for (uint8_t t = 0; t < ARRAY_SIZE(tempos); t++) {
+    accum88 bpm = tempos[t];
+    BeatController clock;
+    LegacyBeats legacy;
+    clock.setup();
+    clock.sync(bpm, 0);
+    legacy.sync(bpm);
+    uint64_t start = host.clock;
+
+    int32_t worst = 0;
+    uint64_t end = start + (uint64_t)DRIFT_HOURS * 3600 * 1000000;
+    for (uint32_t step = 0; host.clock < end; step++) {
+      // Frames every 3.0-3.7ms, and a 50ms stall now and then
+      host_charge(step % 100000 == 99999 ? 50000 : 3000 + random(700));
+      clock.update();
+      legacy.update(globalTimer.delta_micros);
+
+      uint64_t expected = (host.clock - start) * bpm / 60000000;
+      int32_t error = (int32_t)(clock.frac - (BeatFrame_24_8)expected);
+      if (abs(error) > abs(worst))
+        worst = error;
+    }
+
+    uint64_t expected = (host.clock - start) * bpm / 60000000;
+    int32_t legacy_error = (int32_t)(legacy.frac - (BeatFrame_24_8)expected);
+    printf("%.2f,%u,%llu,%d,%d\n", bpm / 256.0, DRIFT_HOURS, (unsigned long long)expected, worst, legacy_error);
+    CHECK(abs(worst) <= 1);
+  }
+
+  return check_status();
+}
@@ -0,0 +1,95 @@
+// The packed-pixel blend kernel against the per-channel one it replaced, on
+// random pixels: scale_rgb against scale8 with either FASTLED_SCALE8_FIXED
+// multiplier, max_rgb against CRGB's |=, and blend_pixels (overwrite and
+// max) against a pair of nscale8x3 calls followed by = or |=.  Boards with
+// the HDR buffer don't use it, but it's a template, so it builds here anyway.
+
+#include "tube.h"
+#include "tests/check.h"
+
+#define PIXELS 200000
+#define BLEND_ROUNDS 200
+
+static uint32_t random_rgb() {
+  return random(0x1000000);
+}
+
+static CRGB to_crgb(uint32_t rgb) {
+  CRGB c;
+  unpack_rgb(c, rgb);
+  return c;
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+
+  // Scale and max, channel by channel
+  uint32_t scale_fixed_wrong = 0, scale_plain_wrong = 0, max_wrong = 0;
+  for (uint32_t n = 0; n < PIXELS; n++) {
+    uint32_t a = random_rgb(), b = random_rgb();
+    uint8_t scale = random(256);
+    CRGB ca = to_crgb(a), cb = to_crgb(b);
+
+    CRGB fixed = ca;
+    nscale8x3(fixed.r, fixed.g, fixed.b, scale);
+    if (to_crgb(scale_rgb(a, scale + 1)) != fixed)
+      scale_fixed_wrong++;
+
+    CRGB plain = CRGB((ca.r * scale) >> 8, (ca.g * scale) >> 8, (ca.b * scale) >> 8);
+    if (to_crgb(scale_rgb(a, scale)) != plain)
+      scale_plain_wrong++;
+
+    CRGB max = ca;
+    max |= cb;
+    if (to_crgb(max_rgb(a, b)) != max)
+      max_wrong++;
+  }
+  CHECK_EQ(scale_fixed_wrong, 0);
+  CHECK_EQ(scale_plain_wrong, 0);
+  CHECK_EQ(max_wrong, 0);
+
+  // Whole strips, against the old kernel over the same resampled pixels
+  VirtualStrip *vstrip = controller.vstrips[0];
+  uint8_t num_leds = controller.num_leds;
+  CRGB *strip = new CRGB[num_leds];
+  CRGB *expected = new CRGB[num_leds];
+  uint32_t overwrite_wrong = 0, max_blend_wrong = 0;
+  for (int round = 0; round < BLEND_ROUNDS; round++) {
+    for (uint16_t i = 0; i < vstrip->num_leds; i++)
+      vstrip->leds[i] = to_crgb(random_rgb());
+    for (uint8_t i = 0; i < num_leds; i++)
+      strip[i] = expected[i] = to_crgb(random_rgb());
+    uint8_t brightness = random(256), fader = random(256);
+
+    unsigned first, last;
+    vstrip->start_blend<VIRTUAL_RATIO>(num_leds, first, last);
+    for (unsigned i = 0; i < num_leds; i++) {
+      CRGB c = to_crgb((i < first || i >= last)
+        ? vstrip->resample<VIRTUAL_RATIO, true>(i)
+        : vstrip->resample<VIRTUAL_RATIO, false>(i));
+      nscale8x3(c.r, c.g, c.b, brightness);
+      nscale8x3(c.r, c.g, c.b, fader);
+      if (round % 2)
+        expected[i] = c;
+      else
+        expected[i] |= c;
+    }
+
+    if (round % 2)
+      vstrip->blend_pixels<VIRTUAL_RATIO, true>(strip, num_leds, brightness, fader);
+    else
+      vstrip->blend_pixels<VIRTUAL_RATIO, false>(strip, num_leds, brightness, fader);
+    for (uint8_t i = 0; i < num_leds; i++) {
+      if (strip[i] != expected[i])
+        (round % 2 ? overwrite_wrong : max_blend_wrong)++;
+    }
+  }
+  CHECK_EQ(overwrite_wrong, 0);
+  CHECK_EQ(max_blend_wrong, 0);
+  delete[] strip;
+  delete[] expected;
+
+  return check_status();
+}
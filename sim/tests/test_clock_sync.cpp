@@ -0,0 +1,95 @@
+// A follower disciplining its beat clock to a master whose crystal runs
+// MASTER_PPM fast, over a lossy radio with jittery delivery.  Prints the
+// worst phase error and the tempo trim every 30s: the error has to settle
+// within two fracs (4ms at 120bpm) and the trim has to find the master's
+// drift.  When the master goes quiet, the tube has to take over with its
+// trim cleared.
+
+#include "tube.h"
+#include "tests/check.h"
+#include "tests/packets.h"
+
+#define MASTER_ID 254
+#define MASTER_PPM 200
+#define MASTER_BPM (120 << 8)
+#define LOSS_PERCENT 30
+#define DELIVERY_MICROS 500         // send + airtime
+#define JITTER_MICROS 1000          // on top: the loops and interrupts at both ends
+#define SYNC_SECONDS 600
+#define SETTLE_SECONDS 120
+#define WINDOW_SECONDS 30
+
+static uint64_t master_start;
+
+// The master's exact phase, in fracs
+double master_fracs(uint64_t clock) {
+  double seconds = (clock - master_start) / 1e6 * (1 + MASTER_PPM / 1e6);
+  return 777.3 + seconds * MASTER_BPM / 256.0 / 60.0 * 256.0;
+}
+
+// The follower's phase at its last beat update, in fracs
+double tube_error() {
+  uint64_t updated = host.clock - (uint32_t)(micros() - globalTimer.now_micros);
+  return beats.phase() / (double)(1 << 24) - master_fracs(updated);
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  master_start = host.clock;
+
+  TubeState current = controller.current_state;
+  TubeState next = controller.next_state;
+  current.bpm = next.bpm = MASTER_BPM;
+
+  printf("seconds,worst_error_fracs,trim_ppm,delivered,lost\n");
+  uint32_t delivered = 0, lost = 0;
+  double worst = 0, settled_worst = 0;
+  uint64_t send_at = host.clock + 500000;
+  for (uint32_t ms = 1; ms <= SYNC_SECONDS * 1000; ms++) {
+    uint64_t until = master_start + ms * 1000ULL;
+    if (send_at < until) {
+      tube_run_until(send_at + DELIVERY_MICROS + random(JITTER_MICROS));
+      current.beat_frame = master_fracs(send_at);
+      RadioMessage message = make_state(MASTER_ID, current, next);
+      if (random(100) < LOSS_PERCENT)
+        lost++;
+      else if (deliver(message))
+        delivered++;
+      send_at += RADIO_SENDPERIOD * 1000;
+    }
+    tube_run_until(until);
+
+    HostPacket sent;
+    while (host_radio_take(&sent))
+      ;
+
+    double error = fabs(tube_error());
+    if (error > worst)
+      worst = error;
+    if (ms > SETTLE_SECONDS * 1000 && error > settled_worst)
+      settled_worst = error;
+    if (ms % (WINDOW_SECONDS * 1000) == 0) {
+      printf("%u,%.2f,%.0f,%u,%u\n", ms / 1000, worst,
+             controller.sync_clock->trim * 1e6 / (1 << 24), delivered, lost);
+      worst = 0;
+    }
+  }
+
+  CHECK_EQ(radio.masterTubeId, MASTER_ID);
+  CHECK(settled_worst < 2.0);
+  double trim_ppm = controller.sync_clock->trim * 1e6 / (1 << 24);
+  CHECK(trim_ppm > MASTER_PPM * 0.75 && trim_ppm < MASTER_PPM * 1.25);
+
+  // The master goes quiet: the tube leads, without the old master's trim
+  uint32_t sends = host.radio.sends;
+  tube_run_for(RADIO_SENDPERIOD * 10 * 1000ULL);
+  CHECK_EQ(radio.masterTubeId, 0);
+  CHECK(!controller.following);
+  CHECK_EQ(controller.sync_clock->trim, 0);
+  CHECK_EQ(controller.sync_clock->pending, 0);
+  CHECK(host.radio.sends > sends);
+
+  return check_status();
+}
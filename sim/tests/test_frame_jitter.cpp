@@ -0,0 +1,116 @@
+// Frame timing under LCD and radio load, with the deadline scheduler and
+// with a plain loop that runs every released task in turn (the way loop()
+// polled its timers before).  Another tube's updates arrive at 20 a second
+// and are relayed, so each costs a send; the LCD redraws its counters every
+// 10ms.  Prints how far the interval between frames strays from the
+// refresh period: the scheduler must keep every frame within 100us, and do
+// better than the plain loop.
+
+#include "tube.h"
+#include "tests/check.h"
+#include "tests/packets.h"
+
+#define OTHER_TUBE 253
+#define LOAD_SECONDS 20
+#define PACKETS_PER_SECOND 20
+
+static uint32_t last_show = 0;
+static uint32_t shows = 0;
+static uint32_t max_jitter = 0;
+static uint32_t jitter_over_500 = 0;
+
+static void measure_frame() {
+  uint32_t now = micros();
+  if (shows++) {
+    int32_t interval = now - last_show;
+    uint32_t jitter = abs(interval - (int32_t)LEDs::REFRESH_PERIOD);
+    if (jitter > max_jitter)
+      max_jitter = jitter;
+    if (jitter > 500)
+      jitter_over_500++;
+  }
+  last_show = now;
+}
+
+static void reset_jitter() {
+  shows = max_jitter = jitter_over_500 = 0;
+}
+
+// Without the scheduler: every task whose period is up runs, in table order
+static void plain_run_until(uint64_t until) {
+  while (host.clock < until) {
+    bool ran = false;
+    for (uint8_t i = 0; i < scheduler.num_tasks; i++) {
+      Task &task = scheduler.tasks[i];
+      uint32_t now = micros();
+      if ((int32_t)(now - task.release) < 0)
+        continue;
+      task.fn();
+      task.release += task.period;
+      if ((int32_t)(now - task.release) >= 0)
+        task.release = now + task.period;
+      ran = true;
+    }
+    host_charge(TUBE_LOOP_MICROS);
+    if (ran)
+      continue;
+
+    int32_t wait = INT32_MAX;
+    for (uint8_t i = 0; i < scheduler.num_tasks; i++) {
+      int32_t until_release = scheduler.tasks[i].release - micros();
+      if (until_release < wait)
+        wait = until_release;
+    }
+    if (wait <= 0 || host.clock >= until)
+      continue;
+    if (host.clock + wait > until)
+      wait = until - host.clock;
+    host_charge(wait);
+  }
+}
+
+// Runs for LOAD_SECONDS with the other tube's packets arriving at random times
+static void run_loaded(bool plain) {
+  reset_jitter();
+  uint32_t sends = host.radio.sends;
+  uint64_t end = host.clock + LOAD_SECONDS * 1000000ULL;
+  while (host.clock < end) {
+    uint64_t until = host.clock + random(2 * 1000000 / PACKETS_PER_SECOND);
+    if (plain)
+      plain_run_until(until);
+    else
+      tube_run_until(until);
+
+    TubeState state = controller.current_state;
+    RadioMessage message = make_state(OTHER_TUBE, state, controller.next_state);
+    deliver(message);
+
+    HostPacket sent;
+    while (host_radio_take(&sent))
+      ;
+  }
+
+  printf("%s,%u,%u,%u,%u\n", plain ? "plain loop" : "scheduler", shows, max_jitter,
+         jitter_over_500, host.radio.sends - sends);
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  CHECK(controller.lcd->active);
+  host.on_show = measure_frame;
+
+  printf("loop,frames,max_jitter_us,frames_over_500us,sends\n");
+  uint32_t sends = host.radio.sends;
+  run_loaded(false);
+  uint32_t scheduled_jitter = max_jitter;
+  CHECK(host.radio.sends > sends);
+  CHECK(shows > LOAD_SECONDS * LEDs::FRAMES_PER_SECOND * 99 / 100);
+  CHECK(scheduled_jitter <= 100);
+
+  run_loaded(true);
+  CHECK(max_jitter > scheduled_jitter);
+
+  return check_status();
+}
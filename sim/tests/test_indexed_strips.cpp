@@ -0,0 +1,67 @@
+// Built with INDEXED_VSTRIPS, where a virtual pixel is a palette index and a
+// value and can't mix two colors: add() and lighten() keep the brighter
+// pixel's color, add() sums the values, and a dimmer color never takes
+// over.  Then the whole show runs on indexed strips for a while.
+
+#include "tube.h"
+#include "tests/check.h"
+
+#ifndef INDEXED_VSTRIPS
+#error "test_indexed_strips needs -DINDEXED_VSTRIPS"
+#endif
+
+#define BRIGHT_COLOR 10
+#define DIM_COLOR 200
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+
+  VirtualStrip *strip = controller.vstrips[0];
+
+  // add(): a dimmer color adds its value but leaves the brighter color
+  strip->paint(0, BRIGHT_COLOR, 0, 150);
+  strip->add(0, DIM_COLOR, 0, 50);
+  CHECK_EQ(strip->index[0], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[0], 200);
+
+  // ...and a brighter one takes the pixel, saturating
+  strip->paint(1, DIM_COLOR, 0, 50);
+  strip->add(1, BRIGHT_COLOR, 0, 150);
+  CHECK_EQ(strip->index[1], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[1], 200);
+  strip->add(1, DIM_COLOR, 0, 100);
+  CHECK_EQ(strip->index[1], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[1], 255);
+
+  // The default value is full brightness
+  strip->paint(2, DIM_COLOR, 0, 100);
+  strip->add(2, BRIGHT_COLOR);
+  CHECK_EQ(strip->index[2], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[2], 255);
+
+  // lighten(): the brighter pixel stays as it is
+  strip->paint(3, BRIGHT_COLOR, 0, 150);
+  strip->lighten(3, DIM_COLOR, 0, 50);
+  CHECK_EQ(strip->index[3], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[3], 150);
+
+  strip->paint(4, DIM_COLOR, 0, 50);
+  strip->lighten(4, BRIGHT_COLOR, 0, 150);
+  CHECK_EQ(strip->index[4], BRIGHT_COLOR);
+  CHECK_EQ(strip->value[4], 150);
+
+  // With the offset added to the color
+  strip->paint(5, DIM_COLOR, 0, 50);
+  strip->lighten(5, BRIGHT_COLOR, 5);
+  CHECK_EQ(strip->index[5], BRIGHT_COLOR + 5);
+  CHECK_EQ(strip->value[5], 255);
+
+  // Every pattern draws on indexed strips
+  uint32_t frames = host.frame_count;
+  tube_run_for(30000000);
+  CHECK(host.frame_count - frames > 30 * LEDs::FRAMES_PER_SECOND * 9 / 10);
+
+  return check_status();
+}
@@ -0,0 +1,47 @@
+// The LCD only sends changed regions, a chunk per loop: with the display on
+// a 400KHz I2C bus, no pass of the LCD task may outrun its budget, and the
+// frame task never misses its deadline, while sending the whole buffer
+// (what display() did every loop) blocks for tens of milliseconds.
+
+#include "tube.h"
+#include "tests/check.h"
+
+static Task *find_task(const char *name) {
+  for (uint8_t i = 0; i < scheduler.num_tasks; i++) {
+    if (!strcmp((const char *)scheduler.tasks[i].name, name))
+      return &scheduler.tasks[i];
+  }
+  return NULL;
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  CHECK(controller.lcd->active);
+  CHECK_EQ(host.i2c_clock, 400000);
+
+  Task *lcd = find_task("lcd");
+  Task *frame = find_task("frame");
+  CHECK(lcd && frame);
+  if (!lcd || !frame)
+    return check_status();
+
+  // The first seconds repaint the whole screen, then only the counters
+  uint64_t bytes = host.i2c_bytes;
+  tube_run_for(20000000);
+  printf("lcd: %u runs, max %uus per update() (budget %uus), %llu bytes sent\n",
+    lcd->runs, lcd->max_runtime, lcd->budget, (unsigned long long)(host.i2c_bytes - bytes));
+  printf("frame: %u runs, %u misses, max %uus late\n", frame->runs, frame->misses, frame->max_late);
+
+  uint64_t start = host.clock;
+  display.display();
+  uint32_t full = host.clock - start;
+  printf("display(): %uus for the whole buffer\n", full);
+
+  CHECK(lcd->runs > 0);
+  CHECK(lcd->max_runtime <= lcd->budget);
+  CHECK_EQ(frame->misses, 0);
+  CHECK(full > 20000);
+  return check_status();
+}
@@ -0,0 +1,49 @@
+// NoiseRow against inoise8: every x and every y of a full lattice cell (and
+// into the next, so the walk steps across a cell edge), the 17 step that
+// fillnoise8 draws with, steps longer than a cell, and rows that start
+// partway into a cell or in a later one.  Every value must match.
+
+#include "tube.h"
+#include "tests/check.h"
+
+// Compares a row of `width` values from (x, y), `step` apart; returns the
+// number that differ
+static uint32_t row_mismatches(uint16_t x, uint16_t step, uint16_t y, uint16_t width) {
+  uint32_t mismatches = 0;
+  NoiseRow row(x, step, y);
+  for (uint16_t i = 0; i < width; i++) {
+    if (row.next() != inoise8(x + i * step, y))
+      mismatches++;
+  }
+  return mismatches;
+}
+
+int main() {
+  // One cell high, two cells wide, a pixel at a time
+  uint32_t mismatches = 0;
+  for (uint16_t y = 0; y < 256; y++)
+    mismatches += row_mismatches(0, 1, y, 512);
+  CHECK_EQ(mismatches, 0);
+
+  // fillnoise8's step, across a whole strip of cells
+  mismatches = 0;
+  for (uint16_t y = 0; y < 256; y++)
+    mismatches += row_mismatches(0, 17, y, 256);
+  CHECK_EQ(mismatches, 0);
+
+  // Steps that skip cells, rows that start mid-cell, and later cells in y,
+  // up to where x and y wrap
+  static const uint16_t steps[] = { 3, 255, 256, 257, 1000 };
+  static const uint16_t starts[] = { 100, 255, 0x7F80, 0xFF00 };
+  static const uint16_t ys[] = { 0x100, 0x17F, 0x4321, 0xFFFF };
+  mismatches = 0;
+  for (uint16_t step : steps) {
+    for (uint16_t x : starts) {
+      for (uint16_t y : ys)
+        mismatches += row_mismatches(x, step, y, 300);
+    }
+  }
+  CHECK_EQ(mismatches, 0);
+
+  return check_status();
+}
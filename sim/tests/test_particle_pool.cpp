@@ -0,0 +1,55 @@
+// Particles come from a fixed pool: once setup() is done, a show full of
+// fireworks and glitter makes no heap allocations at all.
+
+#include "tube.h"
+#include "tests/check.h"
+
+#include <new>
+
+static uint32_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *p = malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void operator delete(void *p) noexcept {
+  free(p);
+}
+
+void operator delete(void *p, size_t size) noexcept {
+  free(p);
+}
+
+static uint8_t most_particles = 0;
+
+static void count_particles() {
+  if (particles.length() > most_particles)
+    most_particles = particles.length();
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  uint32_t boot_allocations = allocations;
+  CHECK(boot_allocations > 0);
+
+  host.on_show = count_particles;
+  const uint32_t seconds = 60;
+  for (uint32_t s = 0; s < seconds; s++) {
+    host_serial_input("f\ng\ng\n");
+    tube_run_for(1000000);
+  }
+
+  uint32_t after_boot = allocations - boot_allocations;
+  printf("allocations: %u in setup(), %u in %us of show (%.2f/s); up to %u of %u particles live\n",
+    boot_allocations, after_boot, seconds, (double)after_boot / seconds, most_particles, MAX_PARTICLES);
+  CHECK_EQ(after_boot, 0);
+  CHECK_EQ(most_particles, MAX_PARTICLES);
+
+  return check_status();
+}
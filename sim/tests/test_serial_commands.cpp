@@ -0,0 +1,153 @@
+// Replays a script of serial commands, pasted all at once and typed at
+// 115200 baud, under light and heavy frames.  Each line sets a brightness
+// one higher than the last, so the brightness tells how many lines have run
+// and that none were lost.  read_keys drains what has arrived, so a typed
+// line runs within a keys period (and a frame or two) of its newline, and a
+// typed script takes as long as the typing whatever the frames cost.
+// Reading a byte per call (the way read_keys did before) paces a paste by
+// the loop.
+
+#include "tube.h"
+#include "tests/check.h"
+
+#define SCRIPT_LINES 200
+#define FIRST_BRIGHTNESS 20
+#define BYTES_PER_MILLI 11            // 115200 baud, 10 bits a byte
+#define STEP_MICROS 100
+#define KEYS_PERIOD 5000
+
+static char script[SCRIPT_LINES * 8];
+static uint32_t line_end[SCRIPT_LINES];   // offset just past each line's newline
+
+static void write_script() {
+  size_t at = 0;
+  for (int i = 0; i < SCRIPT_LINES; i++) {
+    at += sprintf(script + at, "l%u\n", FIRST_BRIGHTNESS + 1 + i);
+    line_end[i] = at;
+  }
+}
+
+static Task *find_task(const char *name) {
+  for (uint8_t i = 0; i < scheduler.num_tasks; i++) {
+    if (!strcmp((const char *)scheduler.tasks[i].name, name))
+      return &scheduler.tasks[i];
+  }
+  return NULL;
+}
+
+// One byte per call, the way read_keys worked before
+static char byte_buffer[KEY_LINE_MAX];
+static uint8_t byte_length = 0;
+
+static void byte_per_call_read_keys() {
+  if (!Serial.available())
+    return;
+  char c = Serial.read();
+  if (c == '\n') {
+    byte_buffer[byte_length] = 0;
+    controller.keyboard_command(byte_buffer);
+    byte_length = 0;
+  } else if (byte_length < sizeof(byte_buffer) - 1) {
+    byte_buffer[byte_length++] = c;
+  }
+}
+
+static uint32_t lines_run() {
+  return controller.options.brightness - FIRST_BRIGHTNESS;
+}
+
+// Feeds the script, pasted or typed, and returns the worst time from a
+// line's newline arriving to the line running; 0 if lines were lost
+static uint32_t replay(bool typed, uint64_t *total) {
+  controller.setBrightness(FIRST_BRIGHTNESS);
+  size_t len = strlen(script);
+  size_t fed = 0;
+  uint32_t ran = 0;
+  uint64_t arrived[SCRIPT_LINES];
+  uint32_t max_latency = 0;
+  uint64_t start = host.clock;
+  uint64_t next_feed = host.clock;
+
+  while (ran < SCRIPT_LINES && host.clock - start < 30000000) {
+    if (fed < len && host.clock >= next_feed) {
+      size_t n = typed ? min(len - fed, (size_t)BYTES_PER_MILLI) : len - fed;
+      char chunk[sizeof(script)];
+      memcpy(chunk, script + fed, n);
+      chunk[n] = 0;
+      host_serial_input(chunk);
+      for (int i = 0; i < SCRIPT_LINES; i++) {
+        if (line_end[i] > fed && line_end[i] <= fed + n)
+          arrived[i] = host.clock;
+      }
+      fed += n;
+      next_feed += 1000;
+    }
+
+    tube_run_for(STEP_MICROS);
+    uint32_t now_ran = min(lines_run(), (uint32_t)SCRIPT_LINES);
+    for (; ran < now_ran; ran++) {
+      uint32_t latency = host.clock - arrived[ran];
+      if (latency > max_latency)
+        max_latency = latency;
+    }
+
+    HostPacket sent;
+    while (host_radio_take(&sent))
+      ;
+  }
+
+  *total = host.clock - start;
+  return ran == SCRIPT_LINES && !Serial.available() ? max_latency : 0;
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  write_script();
+
+  Task *keys = find_task("keys");
+  CHECK(keys);
+  if (!keys)
+    return check_status();
+  TaskFn read_keys = keys->fn;
+
+  printf("reader,frame_us,feed,lines,max_latency_us,total_us\n");
+  static const uint32_t frame_costs[] = { 300, 1500, 3000 };
+  uint32_t worst_pasted = 0;
+  uint64_t least_typed = UINT64_MAX, most_typed = 0;
+  for (int typed = 0; typed < 2; typed++) {
+    for (uint32_t cost : frame_costs) {
+      host.show_micros = cost;
+      uint64_t total;
+      uint32_t latency = replay(typed, &total);
+      printf("drain,%u,%s,%u,%u,%llu\n", cost, typed ? "typed" : "pasted", SCRIPT_LINES,
+        latency, (unsigned long long)total);
+
+      CHECK(latency > 0);
+      if (typed) {
+        // Each line runs within a keys period, and the frames ahead of it
+        CHECK(latency <= KEYS_PERIOD + 2 * LEDs::REFRESH_PERIOD);
+        least_typed = min(least_typed, total);
+        most_typed = max(most_typed, total);
+      } else {
+        // A paste takes a few passes of the loop, not one per byte
+        CHECK(latency <= 4 * KEYS_PERIOD);
+        worst_pasted = max(worst_pasted, latency);
+      }
+    }
+  }
+  // Typed, the script takes as long as the typing, whatever the frames cost
+  CHECK(most_typed - least_typed <= 2 * KEYS_PERIOD);
+
+  keys->fn = byte_per_call_read_keys;
+  host.show_micros = 1000;
+  uint64_t total;
+  uint32_t latency = replay(false, &total);
+  printf("byte per call,%u,pasted,%u,%u,%llu\n", host.show_micros, SCRIPT_LINES,
+    latency, (unsigned long long)total);
+  CHECK(latency > 100 * worst_pasted);
+  keys->fn = read_keys;
+
+  return check_status();
+}
@@ -0,0 +1,43 @@
+// The host build itself: lib8tion math matches FastLED, the clock only moves
+// when charged, and frames come out at the strip's refresh rate.
+
+#include "tube.h"
+#include "tests/check.h"
+
+static uint32_t frames = 0;
+static uint32_t last_show = 0;
+static uint32_t max_gap = 0;
+
+static void count_frame() {
+  uint32_t now = micros();
+  if (frames++ && now - last_show > max_gap)
+    max_gap = now - last_show;
+  last_show = now;
+}
+
+int main() {
+  // Known values from FastLED's lib8tion
+  CHECK_EQ(scale8(255, 255), 255);
+  CHECK_EQ(scale8(128, 128), 64);
+  CHECK_EQ(sin8(0), 128);
+  CHECK_EQ(sin8(64), 255);
+  CHECK_EQ(sin16(0), 0);
+  CHECK_EQ(sin16(16384), 32645);
+  CHECK_EQ(qadd8(200, 100), 255);
+  CHECK_EQ(qsub8(100, 200), 0);
+  CHECK_EQ(ease8InOutQuad(128), 129);
+
+  host_reset(1);
+  host.serial_out = NULL;
+  CHECK_EQ(micros(), 0);
+  tube_boot();
+  CHECK_EQ(millis(), 2000);  // setup()'s delay
+
+  host.on_show = count_frame;
+  tube_run_for(10000000);
+  CHECK(frames >= 2990 && frames <= 3010);
+  CHECK(max_gap <= LEDs::REFRESH_PERIOD + 100);
+  CHECK(host.radio.sends > 0);
+
+  return check_status();
+}
@@ -0,0 +1,68 @@
+// A strip that finishes fading out during a frame draws nothing, so the
+// next live strip has to overwrite last frame's pixels rather than add to
+// them.  Fills the buffer with white and fades out the first strip in the
+// same frame: the frame mustn't come out white, bar a pixel or two that an
+// effect dims.  With no strip left, effects mustn't look for a palette.
+
+#include "tube.h"
+#include "tests/check.h"
+
+static uint8_t white_pixels() {
+  uint8_t white = 0;
+  for (uint8_t i = 0; i < controller.num_leds; i++) {
+#ifdef HDR_BUFFER
+    RGB16 &p = controller.accum->pixels[i];
+    if (p.r == 65535 && p.g == 65535 && p.b == 65535)
+      white++;
+#else
+    if (controller.led_strip->leds[i] == CRGB(CRGB::White))
+      white++;
+#endif
+  }
+  return white;
+}
+
+static void fill_white() {
+  for (uint8_t i = 0; i < controller.num_leds; i++) {
+#ifdef HDR_BUFFER
+    controller.accum->pixels[i] = { 65535, 65535, 65535 };
+#else
+    controller.led_strip->leds[i] = CRGB::White;
+#endif
+  }
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  tube_run_for(5000000);
+
+  // The first strip dies in this frame's update(); the second is live
+  VirtualStrip *dying = controller.vstrips[0];
+  VirtualStrip *live = controller.vstrips[1];
+  live->load(dying->background);
+  live->fade = Steady;
+  live->fader = 65535;
+  dying->fade = FadeOut;
+  dying->fader = 0;
+  dying->fade_speed = 1;
+  controller.vstrips[2]->fade = Dead;
+
+  fill_white();
+  controller.updateGraphics();
+  CHECK_EQ(dying->fade, Dead);
+  CHECK(white_pixels() < controller.num_leds / 2);
+
+  // With every strip dead, the frame starts from black, and an effect that
+  // fires every frame has no strip to take a color from
+  live->fade = Dead;
+  controller.effects->effect = Glitter;
+  controller.effects->beat = (BeatPulse)0;
+  controller.effects->chance = 255;
+  fill_white();
+  controller.updateGraphics();
+  CHECK(white_pixels() < controller.num_leds / 2);
+
+  return check_status();
+}
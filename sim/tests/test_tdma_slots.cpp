@@ -0,0 +1,65 @@
+// With RADIO_TDMA, a leading tube that hears another tube's own message
+// during its slot has to move to another slot; relayed messages, and
+// messages heard outside the slot, leave it where it is.  A follower doesn't
+// send, so it never moves.
+
+#include "tube.h"
+#include "tests/check.h"
+#include "tests/packets.h"
+
+#define LOWER_TUBE 5                // below any random ID, so otherwise ignored
+#define HIGHER_TUBE 253
+
+// Runs until the tube is in (or out of) its slot, and a little further
+static void run_to_slot(bool in) {
+  while (radio.inSlot() != in)
+    tube_run_for(100);
+  tube_run_for(200);
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  CHECK_EQ(radio.slot(), radio.tubeId % RADIO_TDMA_SLOTS);
+
+  // Heard outside the slot
+  run_to_slot(false);
+  uint8_t slot = radio.slot();
+  RadioMessage outside = make_message(LOWER_TUBE, COMMAND_HELLO);
+  CHECK(deliver(outside));
+  tube_run_for(2000);
+  CHECK_EQ(radio.slot(), slot);
+
+  // A relay in the slot
+  run_to_slot(true);
+  RadioMessage relayed = make_message(LOWER_TUBE, COMMAND_HELLO);
+  relayed.relayId = LOWER_TUBE + 1;
+  CHECK(deliver(relayed));
+  tube_run_for(2000);
+  CHECK_EQ(radio.slot(), slot);
+
+  // Another tube sending in the slot
+  run_to_slot(false);
+  run_to_slot(true);
+  RadioMessage clash = make_message(LOWER_TUBE, COMMAND_HELLO);
+  CHECK(deliver(clash));
+  tube_run_for(2000);
+  CHECK(radio.slot() != slot);
+  CHECK(radio.slot() < RADIO_TDMA_SLOTS);
+
+  // Following a higher tube, a clash in the slot leaves it where it is
+  run_to_slot(false);
+  RadioMessage state = make_state(HIGHER_TUBE, controller.current_state, controller.next_state);
+  CHECK(deliver(state));
+  tube_run_for(2000);
+  CHECK_EQ(radio.masterTubeId, HIGHER_TUBE);
+  slot = radio.slot();
+  run_to_slot(true);
+  RadioMessage followed = make_message(LOWER_TUBE, COMMAND_HELLO);
+  CHECK(deliver(followed));
+  tube_run_for(2000);
+  CHECK_EQ(radio.slot(), slot);
+
+  return check_status();
+}
@@ -0,0 +1,75 @@
+// With RADIO_V1_COMPAT, a tube talks to version 1 tubes during a rollout:
+// it uses their channel, checks and sends their checksum over the data
+// alone, and follows their raw UPDATE/NEXT.  Version 1 messages have no
+// sequence number, so two identical ones are both handled, and their
+// uninitialized age byte isn't taken for clock sync.
+
+#include "tube.h"
+#include "tests/check.h"
+#include "tests/packets.h"
+
+#define OTHER_TUBE 253
+
+// A message the way version 1 firmware builds it
+static RadioMessage make_v1(TubeId id, CommandId command, const void *data, uint8_t size) {
+  RadioMessage message;
+  memset(&message, 0, sizeof(message));
+  message.tubeId = id;
+  message.command = command + (1 << 12);
+  memcpy(message.data, data, size);
+  message.age = 0xA5;                           // padding, never set
+  message.crc = legacy_crc(message.data, MESSAGE_V1_DATA_SIZE);
+  return message;
+}
+
+int main() {
+  host_reset(1);
+  host.serial_out = NULL;
+  tube_boot();
+  CHECK_EQ(host.radio.channel, 101);
+
+  // Alone, it leads, and sends what version 1 tubes understand
+  tube_run_for(1500000);
+  HostPacket sent;
+  bool update = false, next = false;
+  while (host_radio_take(&sent)) {
+    RadioMessage message;
+    memcpy(&message, sent.data, sizeof(message));
+    CHECK_EQ(message.command >> 12, 1);
+    CHECK_EQ(message.crc, legacy_crc(message.data, MESSAGE_V1_DATA_SIZE));
+    CHECK(message.seq != 0);
+    update |= (message.command & 0xFFF) == COMMAND_UPDATE;
+    next |= (message.command & 0xFFF) == COMMAND_NEXT;
+  }
+  CHECK(update);
+  CHECK(next);
+
+  // A version 1 master's UPDATE takes over
+  TubeState state = controller.current_state;
+  state.pattern_id = (state.pattern_id + 1) % gPatternCount;
+  uint32_t received = radio.received_micros;
+  RadioMessage message = make_v1(OTHER_TUBE, COMMAND_UPDATE, &state, sizeof(state));
+  CHECK(deliver(message));
+  tube_run_for(10000);
+  CHECK_EQ(radio.masterTubeId, OTHER_TUBE);
+  CHECK_EQ(controller.current_state.pattern_id, state.pattern_id);
+  CHECK(radio.received_micros != received);
+  CHECK(globalTimer.now_micros - radio.received_micros < 20000);
+
+  // The same bytes again are a new message, not a copy
+  uint32_t heard = radio.stats.received;
+  uint32_t copies = radio.stats.duplicates;
+  CHECK(deliver(message));
+  tube_run_for(10000);
+  CHECK_EQ(radio.stats.received - heard, 1);
+  CHECK_EQ(radio.stats.duplicates, copies);
+
+  // A bad version 1 checksum is still caught
+  uint32_t corrupt = radio.stats.corrupt;
+  message.data[3] ^= 1;
+  CHECK(deliver(message));
+  tube_run_for(10000);
+  CHECK_EQ(radio.stats.corrupt - corrupt, 1);
+
+  return check_status();
+}
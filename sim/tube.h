@@ -0,0 +1,46 @@
+#pragma once
+
+// The tube firmware built for the host, and the loop that drives it on the
+// simulated clock.  Include in exactly one file per program: like the board,
+// a program boots the firmware once.
+
+#include "../Tubes.cpp"
+
+#define TUBE_LOOP_MICROS 2          // one pass of loop() that runs nothing
+
+// Run setup(), after host_reset() and any changes to the board
+void tube_boot() {
+#ifdef RADIO_IRQ_PIN
+  host.radio_irq_pin = RADIO_IRQ_PIN;
+#endif
+  setup();
+}
+
+// Runs loop() until the clock reaches `until`.  When no task was ready, the
+// clock jumps to the next release instead of spinning through idle passes.
+void tube_run_until(uint64_t until) {
+  while (host.clock < until) {
+    uint32_t idle = scheduler.idle;
+    loop();
+    host_charge(TUBE_LOOP_MICROS);
+    if (scheduler.idle == idle)
+      continue;
+
+    uint32_t now = micros();
+    int32_t wait = INT32_MAX;
+    for (uint8_t i = 0; i < scheduler.num_tasks; i++) {
+      int32_t until_release = scheduler.tasks[i].release - now;
+      if (until_release < wait)
+        wait = until_release;
+    }
+    if (wait <= 0 || host.clock >= until)
+      continue;
+    if (host.clock + wait > until)
+      wait = until - host.clock;
+    host_charge(wait);
+  }
+}
+
+void tube_run_for(uint64_t micros) {
+  tube_run_until(host.clock + micros);
+}
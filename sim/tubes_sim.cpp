@@ -0,0 +1,113 @@
+// Runs one tube on the host, faster than real time, and writes its frames.
+//
+//   tubes_sim [options]
+//     --seed N         random seed (default 1); the same seed gives the same show
+//     --seconds S      simulated run time after setup() (default 60)
+//     --frames FILE    write every frame (see host_write_frame in host/host.h)
+//     --ppm FILE       write the frames as an image, one row per frame
+//     --keys TEXT      type TEXT on the serial port after setup(); "\n" ends a line
+//     --master         boot with the master pin held low
+//     --no-radio       boot without a radio
+//     --quiet          discard the serial output
+
+#include "tube.h"
+
+#include <string>
+#include <vector>
+
+static std::vector<uint8_t> ppm;
+
+static void keep_frame() {
+  for (int i = 0; i < host.num_leds; i++) {
+    ppm.push_back(host.leds[i].r);
+    ppm.push_back(host.leds[i].g);
+    ppm.push_back(host.leds[i].b);
+  }
+}
+
+static std::string unescape(const char *text) {
+  std::string out;
+  for (const char *c = text; *c; c++) {
+    if (c[0] == '\\' && c[1] == 'n') {
+      out += '\n';
+      c++;
+    } else {
+      out += *c;
+    }
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  uint32_t seed = 1;
+  double seconds = 60;
+  const char *frames = NULL;
+  const char *ppm_file = NULL;
+  std::string keys;
+  bool master_pin = false, radio = true, quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool more = i + 1 < argc;
+    if (arg == "--seed" && more)
+      seed = strtoul(argv[++i], NULL, 0);
+    else if (arg == "--seconds" && more)
+      seconds = atof(argv[++i]);
+    else if (arg == "--frames" && more)
+      frames = argv[++i];
+    else if (arg == "--ppm" && more)
+      ppm_file = argv[++i];
+    else if (arg == "--keys" && more)
+      keys += unescape(argv[++i]);
+    else if (arg == "--master")
+      master_pin = true;
+    else if (arg == "--no-radio")
+      radio = false;
+    else if (arg == "--quiet")
+      quiet = true;
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    }
+  }
+
+  host_reset(seed);
+  host.radio.present = radio;
+  if (master_pin)
+    host.pins[MASTER_PIN] = LOW;
+  if (quiet)
+    host.serial_out = NULL;
+  tube_boot();
+
+  FILE *out = NULL;
+  if (frames) {
+    out = fopen(frames, "wb");
+    if (!out) {
+      perror(frames);
+      return 1;
+    }
+    host.frames = out;
+  }
+  if (ppm_file)
+    host.on_show = keep_frame;
+
+  host_serial_input(keys.c_str());
+  uint64_t start = host.clock;
+  tube_run_until(start + (uint64_t)(seconds * 1000000));
+
+  if (out)
+    fclose(out);
+  if (ppm_file && host.num_leds) {
+    FILE *image = fopen(ppm_file, "wb");
+    if (!image) {
+      perror(ppm_file);
+      return 1;
+    }
+    fprintf(image, "P6\n%d %zu\n255\n", host.num_leds, ppm.size() / (3 * host.num_leds));
+    fwrite(ppm.data(), 1, ppm.size(), image);
+    fclose(image);
+  }
+
+  fprintf(stderr, "%u frames in %.1fs simulated\n", host.frame_count, (host.clock - start) / 1e6);
+  return 0;
+}
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Decodes the binary event log in a tube's serial output.
+
+Log records are lines of "~" + hex (see log.h); everything else is passed
+through unchanged.
+
+    python3 tools/decode_log.py < capture.txt
+    cat /dev/ttyACM0 | python3 tools/decode_log.py
+"""
+
+import sys
+
+# Keep in sync with LogEvent and LogReason in log.h
+REASONS = {
+    1: "wrong version",
+    2: "relayed from master",
+    3: "lower id",
+    4: "not master",
+}
+
+
+def state(a, b, c):
+    return "P%d C%d @%d.%d" % (b >> 8, b & 0xFF, c >> 12, (c >> 8) % 16)
+
+
+EVENTS = {
+    1: lambda a, b, c: "sent %03x from %d%s" % (b, a, "" if c else " FAILED"),
+    2: lambda a, b, c: "received %03x from %d relay %d seq %d" % (b, a, c >> 8, c & 0xFF),
+    3: lambda a, b, c: "ignored %d: %s" % (a, REASONS.get(b, b)),
+    4: lambda a, b, c: "corrupt from %d: crc %04x should be %04x" % (a, b, c),
+    5: lambda a, b, c: "duplicate %d #%d" % (a, b),
+    6: lambda a, b, c: "relayed %d #%d" % (a, b),
+    7: lambda a, b, c: "update sent " + state(a, b, c),
+    8: lambda a, b, c: "update failed (%d in a row)" % c,
+    9: lambda a, b, c: "obeying %d: %s" % (a, state(a, b, c)),
+    10: lambda a, b, c: "next P%d C%d E%d in %dP %dC %dE" % (b >> 8, b & 0xFF, a, c >> 16, (c >> 8) & 0xFF, c & 0xFF),
+    11: lambda a, b, c: "clock error %d fracs, trim %d" % (b - 0x10000 if b & 0x8000 else b, c - (1 << 32) if c & 0x80000000 else c),
+    12: lambda a, b, c: "unknown state format %d from %d" % (b, a),
+    13: lambda a, b, c: "slot clash with %d: moved to %d" % (a, b),
+}
+
+
+def decode(line):
+    record = line[1:]
+    if len(record) != 24:
+        return line
+
+    try:
+        micros = int(record[0:8], 16)
+        event = int(record[8:10], 16)
+        a = int(record[10:12], 16)
+        b = int(record[12:16], 16)
+        c = int(record[16:24], 16)
+    except ValueError:
+        return line
+
+    text = EVENTS.get(event, lambda a, b, c: "event %d: %d %d %d" % (event, a, b, c))(a, b, c)
+    return "%10.6f %s" % (micros / 1e6, text)
+
+
+def main():
+    for line in sys.stdin:
+        line = line.rstrip("\r\n")
+        print(decode(line) if line.startswith("~") else line)
+
+
+if __name__ == "__main__":
+    main()
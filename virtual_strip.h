@@ -2,9 +2,21 @@
 #define VIRTUAL_STRIP_H
 
 #include "led_strip.h"
+#include "accum.h"
+#include "oscillators.h"
 
 #define DEFAULT_FADE_SPEED 100
 
+// Expand each loaded palette into a 256-entry lookup table, so palette_color
+// is a plain load.  Costs 768 bytes per VirtualStrip: too much for the Teensy LC.
+#if !defined(FASTLED_TEENSYLC) && !defined(NO_PALETTE_LUT)
+#define PALETTE_LUT
+#endif
+
+// INDEXED_VSTRIPS: patterns store a palette index and a brightness per pixel
+// instead of a CRGB, and blend() looks the colors up.  Saves a third of the
+// virtual strips' RAM, but only palette-driven patterns can run.
+
 class VirtualStrip;
 typedef void (*BackgroundFn)(VirtualStrip *strip);
 
@@ -32,12 +44,78 @@ BeatFrame_24_8 swing(BeatFrame_24_8 frame) {
   return (frame & 0xFC00) + fr;  // recompose it
 }
 
+// Packed pixels for blend(): a CRGB is held in one word as 0x00BBGGRR
+inline uint32_t pack_rgb(const CRGB &c) {
+  return c.r | (c.g << 8) | ((uint32_t)c.b << 16);
+}
+
+inline void unpack_rgb(CRGB &c, uint32_t rgb) {
+  c.r = rgb;
+  c.g = rgb >> 8;
+  c.b = rgb >> 16;
+}
+
+// The multiplier nscale8x3 uses for a given scale
+inline uint16_t scale8_multiplier(uint8_t scale) {
+#if FASTLED_SCALE8_FIXED == 1
+  return scale + 1;
+#else
+  return scale;
+#endif
+}
+
+// Same as nscale8x3, with red and blue scaled together in 16-bit lanes
+inline uint32_t scale_rgb(uint32_t rgb, uint16_t multiplier) {
+  uint32_t rb = (((rgb & 0x00FF00FF) * multiplier) >> 8) & 0x00FF00FF;
+  uint32_t g = (((rgb & 0x0000FF00) * multiplier) >> 8) & 0x0000FF00;
+  return rb | g;
+}
+
+// Per-channel max, the same as CRGB's |=.  Only boards without the HDR
+// buffer (the Teensy LC, which has no DSP instructions) blend 8-bit pixels,
+// so this compares two channels at once in 16-bit lanes: a guard bit above
+// each lane survives the subtraction only where a >= b.
+inline uint32_t max_rgb(uint32_t a, uint32_t b) {
+  uint32_t a_rb = a & 0x00FF00FF, b_rb = b & 0x00FF00FF;
+  uint32_t mask = ((((a_rb | 0x01000100) - b_rb) >> 8) & 0x00010001) * 0xFF;
+  uint32_t rb = (a_rb & mask) | (b_rb & ~mask);
+
+  uint8_t a_g = a >> 8, b_g = b >> 8;
+  return rb | ((a_g > b_g ? a_g : b_g) << 8);
+}
+
+#ifdef INDEXED_VSTRIPS
+// Colors of the virtual pixels blend() looked up last.  The filter taps of
+// neighbouring output pixels overlap, so this keeps it to one palette lookup
+// per virtual pixel.  Must hold at least 2*VIRTUAL_RATIO-1 taps.
+#define TAP_CACHE_SIZE 8
+
+class TapCache {
+  public:
+    int16_t pos[TAP_CACHE_SIZE];
+    uint32_t rgb[TAP_CACHE_SIZE];
+
+  void clear() {
+    for (uint8_t i = 0; i < TAP_CACHE_SIZE; i++)
+      this->pos[i] = -1;
+  }
+};
+
+TapCache _tap_cache;
+#endif
+
 class VirtualStrip {
   const static uint16_t DEFAULT_BRIGHTNESS = 192;
 
   public:
+#ifdef INDEXED_VSTRIPS
+    uint8_t index[MAX_VIRTUAL_LEDS];
+    uint8_t value[MAX_VIRTUAL_LEDS];
+#else
     CRGB leds[MAX_VIRTUAL_LEDS];
-    uint8_t num_leds;
+#endif
+    uint8_t noise[MAX_VIRTUAL_LEDS];  // drawNoise's smoothed values
+    uint16_t num_leds;
     uint8_t brightness;
 
     // Fade in/out
@@ -47,6 +125,9 @@ class VirtualStrip {
 
     // Pattern parameters
     Background background;
+#ifdef PALETTE_LUT
+    CRGB lut[256];  // background.palette, expanded by load()
+#endif
     uint32_t frame;
     uint8_t beat;
     uint16_t beat16;  // 8 bits of beat and 8 bits of fractional
@@ -54,7 +135,7 @@ class VirtualStrip {
     bool beat_pulse;
     int bps = 0;
 
-  VirtualStrip(uint8_t num_leds)
+  VirtualStrip(uint16_t num_leds)
   {
     this->fade = Dead;
     this->num_leds = num_leds;
@@ -63,10 +144,15 @@ class VirtualStrip {
   void load(Background &background, uint8_t fade_speed=DEFAULT_FADE_SPEED)
   {
     this->background = background;
+#ifdef PALETTE_LUT
+    for (uint16_t i = 0; i < 256; i++)
+      this->lut[i] = ColorFromPalette(this->background.palette, i);
+#endif
     this->fade = FadeIn;
     this->fader = 0;
     this->fade_speed = fade_speed;
     this->brightness = DEFAULT_BRIGHTNESS;
+    memset(this->noise, 0, sizeof(this->noise));
   }
 
   void fadeOut(uint8_t fade_speed=DEFAULT_FADE_SPEED)
@@ -79,13 +165,74 @@ class VirtualStrip {
 
   void darken(uint8_t amount=10)
   {
+#ifdef INDEXED_VSTRIPS
+    for (uint16_t i = 0; i < this->num_leds; i++)
+      this->value[i] = scale8(this->value[i], 255 - amount);
+#else
     fadeToBlackBy( this->leds, this->num_leds, amount);
+#endif
   }
 
+  void clear()
+  {
+#ifdef INDEXED_VSTRIPS
+    memset(this->value, 0, this->num_leds);
+#else
+    fill_solid( this->leds, this->num_leds, CRGB::Black);
+#endif
+  }
+
+#ifndef INDEXED_VSTRIPS
   void fill(CRGB crgb) 
   {
     fill_solid( this->leds, this->num_leds, crgb);
   }
+#endif
+
+  // Pixel i is palette color c + offset, scaled by value
+  void paint(uint16_t i, uint8_t c, uint8_t offset=0, uint8_t value=255)
+  {
+#ifdef INDEXED_VSTRIPS
+    this->index[i] = c + offset;
+    this->value[i] = value;
+#else
+    CRGB color = this->palette_color(c, offset);
+    if (value != 255)
+      nscale8x3(color.r, color.g, color.b, value);
+    this->leds[i] = color;
+#endif
+  }
+
+  // Adds palette color c + offset, scaled by value, to pixel i.  Indexed
+  // pixels can't mix two colors, so there the brighter one keeps the pixel
+  // and the values add up.
+  void add(uint16_t i, uint8_t c, uint8_t offset=0, uint8_t value=255)
+  {
+#ifdef INDEXED_VSTRIPS
+    if (value >= this->value[i])
+      this->index[i] = c + offset;
+    this->value[i] = qadd8(this->value[i], value);
+#else
+    CRGB color = this->palette_color(c, offset);
+    if (value != 255)
+      nscale8x3(color.r, color.g, color.b, value);
+    this->leds[i] += color;
+#endif
+  }
+
+  // The same, keeping the brighter of each channel (indexed: of each pixel)
+  void lighten(uint16_t i, uint8_t c, uint8_t offset=0, uint8_t value=255)
+  {
+#ifdef INDEXED_VSTRIPS
+    if (value >= this->value[i])
+      this->paint(i, c, offset, value);
+#else
+    CRGB color = this->palette_color(c, offset);
+    if (value != 255)
+      nscale8x3(color.r, color.g, color.b, value);
+    this->leds[i] |= color;
+#endif
+  }
 
   void update(BeatFrame_24_8 frame, uint8_t beat_pulse)
   {
@@ -100,7 +247,7 @@ class VirtualStrip {
 
       case SinDrift:
         // Drift slightly
-        this->frame = frame + (beatsin16( 5 ) >> 6);
+        this->frame = frame + (oscillators.value[DriftOscillator] >> 6);
         break;
 
       case Swing:
@@ -110,12 +257,12 @@ class VirtualStrip {
 
       case SwingDrift:
         // Swing the beat AND drift slightly
-        this->frame = swing(frame) + (beatsin16( 5 ) >> 6);
+        this->frame = swing(frame) + (oscillators.value[DriftOscillator] >> 6);
         break;
 
       case Pulse:
         // Pulsing from 30 - 210 brightness
-        this->brightness = scale8(beatsin8( 10 ), 180) + 30;
+        this->brightness = scale8(oscillators.value[PulseOscillator] >> 8, 180) + 30;
         break;
     }
     this->hue = (this->frame >> 4) % 256;
@@ -152,7 +299,11 @@ class VirtualStrip {
   }
 
   CRGB palette_color(uint8_t c, uint8_t offset=0) {
+#ifdef PALETTE_LUT
+    return this->lut[(uint8_t)(c + offset)];
+#else
     return ColorFromPalette( this->background.palette, c + offset );
+#endif
   }
 
   CRGB hue_color(uint8_t offset=0, uint8_t saturation=255, uint8_t value=192) {
@@ -165,31 +316,136 @@ class VirtualStrip {
 
     brightness = scale8(this->brightness, brightness);
 
-    for (unsigned i=0; i < num_leds; i++) {
-#ifdef DOUBLED
-      uint8_t pos = (2*i + 1) % this->num_leds;  // slope of line is fixed right now at 2:1
-#else
-      uint8_t pos = i;
+    // Pick the variant once, rather than testing overwrite for every pixel
+    if (overwrite)
+      this->blend_pixels<VIRTUAL_RATIO, true>(strip, num_leds, brightness, this->fader>>8);
+    else
+      this->blend_pixels<VIRTUAL_RATIO, false>(strip, num_leds, brightness, this->fader>>8);
+  }
+
+#ifdef HDR_BUFFER
+  void blend(AccumBuffer *accum, uint8_t num_leds, uint8_t brightness, BlendMode mode) {
+    if (this->fade == Dead)
+      return;
+
+    brightness = scale8(this->brightness, brightness);
+
+    // Brightness and the whole 16-bit fader in one multiplier, up to 65536:
+    // a channel at 255 comes out at 255<<8
+    uint32_t multiplier = (scale8_multiplier(brightness) * (this->fader + 1)) >> 8;
+
+    switch (mode) {
+      case OverwriteBlend:
+        this->accumulate_pixels<VIRTUAL_RATIO, OverwriteBlend>(accum, num_leds, multiplier);
+        break;
+      case MaxBlend:
+        this->accumulate_pixels<VIRTUAL_RATIO, MaxBlend>(accum, num_leds, multiplier);
+        break;
+      case AddBlend:
+        this->accumulate_pixels<VIRTUAL_RATIO, AddBlend>(accum, num_leds, multiplier);
+        break;
+    }
+  }
 #endif
 
-      CRGB c = this->leds[pos];
+  // Samples output pixel i from RATIO virtual pixels per physical pixel:
+  // a triangle filter centered on RATIO*i + RATIO/2, with weights
+  // RATIO-|k| that sum to RATIO^2.  Taps past either end of the strip are
+  // clamped to the end pixel when CLAMP is set.
+  template<uint8_t RATIO, bool CLAMP>
+  uint32_t resample(unsigned i) {
+    if (RATIO == 1)
+      return this->tap((CLAMP && i >= this->num_leds) ? this->num_leds-1 : i);
+
+    const uint8_t shift = (RATIO == 4) ? 4 : 2;
+    int center = RATIO * i + RATIO / 2;
+    uint32_t rb = 0, g = 0;
+    for (int k = 1 - RATIO; k < RATIO; k++) {
+      int pos = center + k;
+      if (CLAMP) {
+        if (pos < 0)
+          pos = 0;
+        if (pos >= this->num_leds)
+          pos = this->num_leds - 1;
+      }
+      uint32_t rgb = this->tap(pos);
+      uint8_t weight = RATIO - (k < 0 ? -k : k);
+      rb += (rgb & 0x00FF00FF) * weight;
+      g += (rgb & 0x0000FF00) * weight;
+    }
+    return ((rb >> shift) & 0x00FF00FF) | ((g >> shift) & 0x0000FF00);
+  }
 
-#ifdef DOUBLED
-      CRGB c1 = this->leds[pos-1];
-      CRGB c2 = this->leds[pos+1];
-      nblend(c1, c, 128);
-      nblend(c, c2, 128);
-      nblend(c, c1, 128); // C is now a weighted average of the three virtual pixels
+  // Packed color of virtual pixel pos
+  uint32_t tap(int pos) {
+#ifdef INDEXED_VSTRIPS
+    uint8_t slot = pos % TAP_CACHE_SIZE;
+    if (_tap_cache.pos[slot] != pos) {
+      _tap_cache.pos[slot] = pos;
+      _tap_cache.rgb[slot] = scale_rgb(pack_rgb(this->palette_color(this->index[pos])), scale8_multiplier(this->value[pos]));
+    }
+    return _tap_cache.rgb[slot];
+#else
+    return pack_rgb(this->leds[pos]);
 #endif
+  }
 
-      nscale8x3(c.r, c.g, c.b, brightness);
-      nscale8x3(c.r, c.g, c.b, this->fader>>8);
-      if (overwrite)
-        strip[i] = c;
-      else
-        strip[i] |= c;
+  // Sets up a blend of num_leds output pixels.  Only those outside
+  // [first, last) have a filter that reaches past an end of the strip, and
+  // need clamping.
+  template<uint8_t RATIO>
+  void start_blend(uint8_t num_leds, unsigned &first, unsigned &last) {
+    static_assert(RATIO == 1 || RATIO == 2 || RATIO == 4, "VIRTUAL_RATIO must be 1, 2 or 4");
+#ifdef INDEXED_VSTRIPS
+    static_assert(TAP_CACHE_SIZE >= 2 * RATIO - 1, "TAP_CACHE_SIZE is too small for VIRTUAL_RATIO");
+    _tap_cache.clear();
+#endif
+
+    first = (RATIO / 2 + 1 >= RATIO) ? 0 : 1;
+    last = num_leds;
+    while (last > first && RATIO * (last-1) + RATIO / 2 + RATIO - 1 >= this->num_leds)
+      last--;
+  }
+
+  template<uint8_t RATIO, bool OVERWRITE>
+  void blend_pixels(CRGB strip[], uint8_t num_leds, uint8_t brightness, uint8_t fader) {
+    unsigned first, last;
+    this->start_blend<RATIO>(num_leds, first, last);
+
+    uint16_t brightness_multiplier = scale8_multiplier(brightness);
+    uint16_t fader_multiplier = scale8_multiplier(fader);
+
+    for (unsigned i=0; i < num_leds; i++) {
+      uint32_t rgb = (i < first || i >= last)
+        ? this->resample<RATIO, true>(i)
+        : this->resample<RATIO, false>(i);
+
+      // Two successive scales, as the old pair of nscale8x3 calls did
+      rgb = scale_rgb(scale_rgb(rgb, brightness_multiplier), fader_multiplier);
+      if (!OVERWRITE)
+        rgb = max_rgb(pack_rgb(strip[i]), rgb);
+      unpack_rgb(strip[i], rgb);
+    }
+  }
+
+#ifdef HDR_BUFFER
+  template<uint8_t RATIO, BlendMode MODE>
+  void accumulate_pixels(AccumBuffer *accum, uint8_t num_leds, uint32_t multiplier) {
+    unsigned first, last;
+    this->start_blend<RATIO>(num_leds, first, last);
+
+    for (unsigned i=0; i < num_leds; i++) {
+      uint32_t rgb = (i < first || i >= last)
+        ? this->resample<RATIO, true>(i)
+        : this->resample<RATIO, false>(i);
+
+      accum->blend<MODE>(i,
+        ((rgb & 0xFF) * multiplier) >> 8,
+        (((rgb >> 8) & 0xFF) * multiplier) >> 8,
+        ((rgb >> 16) * multiplier) >> 8);
     }
   }
+#endif
   
   uint8_t bpm_sin16( uint16_t lowest=0, uint16_t highest=65535 )
   {